@@ -6,7 +6,12 @@
 #ifndef CLPP_BUFFER_HPP
 #define CLPP_BUFFER_HPP
 
+#include <atomic>
+#include <memory>
+#include <utility>
+
 #include "resource.hpp"
+#include "device.hpp"
 #include "context.hpp"
 
 namespace clpp {
@@ -24,13 +29,14 @@ class Memory {
         }
 
         /// Get the memory flags corresponding to this memory object.
-        /**
+        /** The flags are queried once when the object is constructed.
+
             \return     The \a flags argument value when the memory object is
                         created by Context::createBuffer.
          */
         cl_mem_flags flags() const
         {
-            return getInfo<cl_mem_flags>(CL_MEM_FLAGS);
+            return my_flags;
         }
 
         /// Get memory object information.
@@ -50,15 +56,77 @@ class Memory {
             return result;
         }
 
+        /// Get the generation of this memory object.
+        /** Every memory object gets a unique generation when a Memory object
+            is constructed from its handle, and copies share it. OpenCL may
+            reuse the handle of a released memory object, but never its
+            generation, so it tells whether two handles refer to the same
+            memory object without retaining it.
+
+            \return     The generation of this memory object.
+         */
+        cl_ulong generation() const
+        {
+            return my_generation;
+        }
+
+        Memory(const Memory&) = default;
+        Memory(Memory&&) = default;
+        Memory& operator=(const Memory&) = default;
+        Memory& operator=(Memory&&) = default;
+
         virtual ~Memory() throw() {}
 
     protected:
-        Memory(cl_mem id) : my_resource(id) {}
+        // The size and flags of a memory object never change, so they are
+        // queried here once instead of on every call of size() or flags().
+        Memory(cl_mem id) : my_resource(id), my_size(0), my_flags(0), my_generation(nextGeneration())
+        {
+            if(id != 0){
+                my_size = getInfo<size_t>(CL_MEM_SIZE);
+                my_flags = getInfo<cl_mem_flags>(CL_MEM_FLAGS);
+            }
+        }
+
+        Memory(cl_mem id, size_t size, cl_mem_flags flags, const std::shared_ptr<void>& lease)
+            : my_resource(id), my_size(size), my_flags(flags), my_lease(lease), my_generation(nextGeneration())
+        {}
+
+        /// Swap the handle and the cached information with another memory object.
+        void swapMemory(Memory& mem) throw()
+        {
+            my_resource.swap(mem.my_resource);
+            std::swap(my_size, mem.my_size);
+            std::swap(my_flags, mem.my_flags);
+            my_lease.swap(mem.my_lease);
+            std::swap(my_generation, mem.my_generation);
+        }
 
         Resource<cl_mem> my_resource;
+
+        // The requested size in bytes. Pooled memory objects may be larger
+        // than requested.
+        size_t my_size;
+
+        cl_mem_flags my_flags;
+
+        // Returns the memory object to its BufferPool when the last handle
+        // is destroyed. It is empty if the memory object is not pooled.
+        std::shared_ptr<void> my_lease;
+
+        cl_ulong my_generation;
+
+    private:
+        static cl_ulong nextGeneration()
+        {
+            static std::atomic<cl_ulong> counter(0);
+            return ++counter;
+        }
 }; // class Memory
 
 
+template <typename T> class BufferView;
+
 /// \brief The OpenCL buffer object.
 /** Buffer is a memory object that stores a linear collection of bytes.
     Buffer objects are accessible using a pointer in a kernel executing on a
@@ -78,25 +146,223 @@ template <typename T> class Buffer : public Memory {
          */
         Buffer(cl_mem id = 0) : Memory(id) {}
 
+        /// Construct a Buffer object whose size and flags are known.
+        /** Please use Context::createBuffer instead of using this constructor
+            directly.
+
+            \param id       The memory object.
+            \param count    The requested number of elements.
+            \param flags    The flags the memory object was created with.
+            \param lease    The lease of a memory object acquired from a
+                            BufferPool, or an empty pointer.
+         */
+        Buffer(cl_mem id, size_t count, cl_mem_flags flags, const std::shared_ptr<void>& lease = std::shared_ptr<void>())
+            : Memory(id, count*sizeof(T), flags, lease)
+        {}
+
         /// Get the number of elements in this memory object.
-        /**
+        /** This function doesn't call OpenCL.
+
             \return     Number of elements.
          */
         size_t size() const
         {
-            return getInfo<size_t>(CL_MEM_SIZE) / sizeof(T);
+            return my_size / sizeof(T);
         }
 
+        /// Get a view of a range of elements in this buffer object.
+        /** The view is backed by a sub-buffer object if OpenCL can create
+            one at the requested offset. Otherwise, e.g. if the offset
+            doesn't meet the base address alignment of a device, the view
+            refers to this whole buffer and BufferView::offset() gives the
+            index of the first element, which must be passed to kernels as
+            an additional argument.
+
+            \param offset   The beginning index of the range.
+            \param count    The number of elements in the range.
+            \param flags    The access flags of the sub-buffer. By default
+                            the flags of this buffer are inherited.
+
+            \return         The view of the range.
+            \throw Error    \c CL_INVALID_VALUE if the range is not within
+                            this buffer.
+         */
+        BufferView<T> slice(size_t offset, size_t count, cl_mem_flags flags = 0) const;
+
+        /// Get a view of a range of elements in this buffer object.
+        /** This version checks the offset against the base address
+            alignment of \a device before creating a sub-buffer, and uses
+            an offset view directly if it is not aligned.
+
+            \param offset   The beginning index of the range.
+            \param count    The number of elements in the range.
+            \param device   The device where the view will be used.
+            \param flags    The access flags of the sub-buffer. By default
+                            the flags of this buffer are inherited.
+
+            \return         The view of the range.
+            \throw Error    \c CL_INVALID_VALUE if the range is not within
+                            this buffer.
+         */
+        BufferView<T> slice(size_t offset, size_t count, Device device, cl_mem_flags flags = 0) const;
+
         /// Swap the pointed content with another buffer object.
         /**
             \param mem  The buffer object to be swapped with.
          */
         void swap(Buffer& mem) throw()
         {
-            my_resource.swap(mem.my_resource);
+            swapMemory(mem);
+        }
+
+    private:
+        void checkRange(size_t offset, size_t count) const
+        {
+            if(offset > size() || count > size() - offset)
+                CLPP_CHECK_ERROR(CL_INVALID_VALUE);
         }
 }; // template <typename T> class Buffer
 
+/// A typed view of a range of elements in a buffer object.
+/** A view is either backed by a sub-buffer object, in which case offset()
+    is 0 and kernels see exactly the elements of the range, or it refers to
+    the whole parent buffer with a non-zero offset(). Please use
+    Buffer::slice to create views.
+
+    Views can be passed to Kernel::setArg and CommandQueue::copy.
+ */
+template <typename T> class BufferView {
+    public:
+        typedef T ValueType;
+
+        /// Construct an empty view.
+        BufferView() : my_parent_offset(0), my_count(0) {}
+
+        /// Construct a view.
+        /** Please use Buffer::slice instead of using this constructor
+            directly.
+
+            \param parent   The buffer object which contains the range.
+            \param offset   The beginning index of the range in \a parent.
+            \param count    The number of elements in the range.
+            \param sub      The sub-buffer object of the range, or a null
+                            buffer if the range is not aligned.
+         */
+        BufferView(const Buffer<T>& parent, size_t offset, size_t count, const Buffer<T>& sub = Buffer<T>())
+            : my_parent(parent), my_sub(sub), my_parent_offset(offset), my_count(count)
+        {}
+
+        /// Get the buffer object which should be bound to kernels.
+        /**
+            \return     The sub-buffer object if there is one, or the parent
+                        buffer object otherwise.
+         */
+        const Buffer<T>& buffer() const
+        {
+            return my_sub.id() != 0 ? my_sub : my_parent;
+        }
+
+        /// Get the \c cl_mem object which should be bound to kernels.
+        cl_mem id() const
+        {
+            return buffer().id();
+        }
+
+        /// Get the index of the first element in buffer().
+        /**
+            \return     0 if the view is backed by a sub-buffer object, or the
+                        beginning index of the range in the parent buffer.
+         */
+        size_t offset() const
+        {
+            return my_sub.id() != 0 ? 0 : my_parent_offset;
+        }
+
+        /// Check if the view is backed by a sub-buffer object.
+        bool isSubBuffer() const
+        {
+            return my_sub.id() != 0;
+        }
+
+        /// Get the parent buffer object.
+        const Buffer<T>& parent() const
+        {
+            return my_parent;
+        }
+
+        /// Get the beginning index of the range in the parent buffer.
+        size_t parentOffset() const
+        {
+            return my_parent_offset;
+        }
+
+        /// Get the number of elements in this view.
+        size_t size() const
+        {
+            return my_count;
+        }
+
+        /// Get a view of a range of elements in this view.
+        /**
+            \param offset   The beginning index of the range in this view.
+            \param count    The number of elements in the range.
+            \param flags    The access flags of the sub-buffer.
+
+            \return         The view of the range.
+            \throw Error    \c CL_INVALID_VALUE if the range is not within
+                            this view.
+         */
+        BufferView slice(size_t offset, size_t count, cl_mem_flags flags = 0) const
+        {
+            if(offset > my_count || count > my_count - offset)
+                CLPP_CHECK_ERROR(CL_INVALID_VALUE);
+            return my_parent.slice(my_parent_offset + offset, count, flags);
+        }
+
+    private:
+        Buffer<T> my_parent;
+        Buffer<T> my_sub;
+        size_t my_parent_offset;
+        size_t my_count;
+}; // template <typename T> class BufferView
+
+template <typename T>
+inline BufferView<T> Buffer<T>::slice(size_t offset, size_t count, cl_mem_flags flags) const
+{
+    checkRange(offset, count);
+#ifdef CL_VERSION_1_1
+    cl_buffer_region region;
+    region.origin = offset*sizeof(T);
+    region.size = count*sizeof(T);
+    cl_int err;
+    cl_mem mem = clCreateSubBuffer(id(), flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+    if(err == CL_MISALIGNED_SUB_BUFFER_OFFSET)
+        return BufferView<T>(*this, offset, count);
+    CLPP_CHECK_ERROR(err);
+
+    // The sub-buffer shares the lease of this buffer, so pooled memory is
+    // not recycled while the sub-buffer is alive. Host pointer flags are
+    // always inherited.
+    const cl_mem_flags access = CL_MEM_READ_WRITE | CL_MEM_WRITE_ONLY | CL_MEM_READ_ONLY;
+    cl_mem_flags sub_flags = flags == 0 ? my_flags : (flags | (my_flags & ~access));
+    return BufferView<T>(*this, offset, count, Buffer<T>(mem, count, sub_flags, my_lease));
+#else
+    return BufferView<T>(*this, offset, count);
+#endif
+}
+
+template <typename T>
+inline BufferView<T> Buffer<T>::slice(size_t offset, size_t count, Device device, cl_mem_flags flags) const
+{
+    checkRange(offset, count);
+
+    // CL_DEVICE_MEM_BASE_ADDR_ALIGN is in bits.
+    size_t align = device.getMemBaseAddrAlign() / 8;
+    if(align != 0 && (offset*sizeof(T)) % align != 0)
+        return BufferView<T>(*this, offset, count);
+    return slice(offset, count, flags);
+}
+
 } // namespace clpp
 
 #endif // CLPP_BUFFER_HPP
@@ -10,11 +10,24 @@
 #include "size.hpp"
 #include "platform.hpp"
 #include "device.hpp"
+#include "deviceinfo.hpp"
 #include "context.hpp"
 #include "commandqueue.hpp"
 #include "buffer.hpp"
+#include "pool.hpp"
+#include "mapped.hpp"
 #include "image.hpp"
 #include "program.hpp"
+#include "programcache.hpp"
+#include "programtemplate.hpp"
+#include "embedded.hpp"
 #include "kernel.hpp"
+#include "kernelfunctor.hpp"
+#include "pipeline.hpp"
+#include "splitlauncher.hpp"
+#include "taskgraph.hpp"
+#include "commandrecording.hpp"
+#include "tuner.hpp"
+#include "typename.hpp"
 
 #endif // CLPP_HPP
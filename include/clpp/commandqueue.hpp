@@ -6,12 +6,17 @@
 #ifndef CLPP_COMMANDQUEUE_HPP
 #define CLPP_COMMANDQUEUE_HPP
 
+#include <memory>
+#include <string>
+
 #include "common.hpp"
 #include "vector.hpp"
 #include "kernel.hpp"
 #include "resource.hpp"
 #include "error.hpp"
 #include "event.hpp"
+#include "mapped.hpp"
+#include "tuner.hpp"
 
 namespace clpp {
 
@@ -26,7 +31,14 @@ class CommandQueue {
         /** Please use Context::createBuffer instead of using this constructor
             directly.
          */
-        CommandQueue(cl_command_queue q) : my_resource(q) {}
+        CommandQueue(cl_command_queue q) : my_resource(q), my_device(queryDevice(q)), my_event_output(true) {}
+
+        /// Construct a command queue whose device is known.
+        /**
+            \param q        The command queue.
+            \param device   The device \a q was created for.
+         */
+        CommandQueue(cl_command_queue q, const Device& device) : my_resource(q), my_device(device), my_event_output(true) {}
 
         /// Get the \c cl_command_queue object created by OpenCL API.
         /**
@@ -37,6 +49,33 @@ class CommandQueue {
             return *my_resource;
         }
 
+        /// Get the device associated with this command queue.
+        /** The device is resolved when the queue is constructed, so its
+            cached limits are reused by every execAuto().
+         */
+        const Device& device() const
+        {
+            return my_device;
+        }
+
+        /// Attach a kernel tuner to this command queue object.
+        /** When a tuner is attached, exec() with an unspecified work-group
+            size, and execAuto(), use the work-group size tuned for the
+            kernel, the device of this queue and the global size bucket if
+            there is one. exec() only uses it if the global size is a
+            multiple of the tuned size.
+
+            Kernel objects remember their names, so looking up a
+            configuration makes no OpenCL calls.
+
+            \param tuner    The tuner, or a null pointer to detach it.
+         */
+        void setTuner(const std::shared_ptr<const KernelTuner>& tuner)
+        {
+            my_tuner = tuner;
+            my_device_name = tuner ? std::string(device().name().c_str()) : std::string();
+        }
+
         /// Set execution mode of this command queue.
         /**
             \param mode     The desired execution mode, \a true for out-of-order
@@ -93,6 +132,48 @@ class CommandQueue {
             setProfiling(false);
         }
 
+        /// Set event output mode of this command queue object.
+        /** By default, every copy and exec function creates an event object
+            for the enqueued command and returns it. When event output is
+            disabled, commands are enqueued without requesting an event, so
+            OpenCL doesn't have to allocate one, and a null Event is returned
+            instead. This is useful for commands whose completion is never
+            checked individually, e.g. fire-and-forget uploads.
+
+            The mode only affects this CommandQueue object. Copies made
+            before the call keep their own mode. marker() always returns an
+            event.
+
+            \param mode     \a true to return events and \a false to enqueue
+                            commands without events.
+         */
+        void setEventOutput(bool mode)
+        {
+            my_event_output = mode;
+        }
+
+        /// Enable event output.
+        /** This function directly calls \c setEventOutput(true).
+         */
+        void enableEvents()
+        {
+            setEventOutput(true);
+        }
+
+        /// Disable event output.
+        /** This function directly calls \c setEventOutput(false).
+         */
+        void disableEvents()
+        {
+            setEventOutput(false);
+        }
+
+        /// Check if commands return events.
+        bool eventOutput() const
+        {
+            return my_event_output;
+        }
+
         /// Flush the command queue.
         /** This function issues all previously queued OpenCL commands to the
             device associated with this command queue. There is \b no guarantee
@@ -124,18 +205,41 @@ class CommandQueue {
             CLPP_CHECK_ERROR( clEnqueueBarrier(id()) );
         }
 
+        /// Insert a barrier which waits for a list of events.
+        /** Commands enqueued after this barrier don't begin execution until
+            all events in \a wait_list are complete. If \a wait_list is
+            empty, this function is the same as barrier().
+
+            \param wait_list    Events that need to complete before the next
+                                batch of commands can begin execution.
+         */
+        void barrier(const EventList& wait_list)
+        {
+            if(wait_list.empty()){
+                barrier();
+                return;
+            }
+#ifdef CL_VERSION_1_2
+            CLPP_CHECK_ERROR( clEnqueueBarrierWithWaitList(id(), wait_list.size(), wait_list.data(), NULL) );
+#else
+            CLPP_CHECK_ERROR( clEnqueueWaitForEvents(id(), wait_list.size(), wait_list.data()) );
+#endif
+        }
+
         /// Copy data from a buffer object to a host memory chunk.
         /**
             \param buffer   The buffer object where data are read.
             \param ptr      The host memory chunk where data are written.
             \param blocking Indicates if the read operations are blocking or
                             non-blocking. By default, blocking read is used.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
          */
-        template <typename T> Event copy(const Buffer<T>& buffer, T* ptr, cl_bool blocking = CL_TRUE)
+        template <typename T> Event copy(const Buffer<T>& buffer, T* ptr, cl_bool blocking = CL_TRUE, const EventList& wait_list = EventList())
         {
-            cl_event event;
+            cl_event event = 0;
             size_t cb = sizeof(T) * buffer.size();
-            cl_int err = clEnqueueReadBuffer(id(), buffer.id(), blocking, 0, cb, ptr, 0, NULL, &event);
+            cl_int err = clEnqueueReadBuffer(id(), buffer.id(), blocking, 0, cb, ptr, wait_list.size(), wait_list.data(), eventPointer(event));
             CLPP_CHECK_ERROR(err);
             return Event(event);
         }
@@ -148,11 +252,13 @@ class CommandQueue {
             \param ptr      The host memory chunk where data are written.
             \param blocking Indicates if the read operations are blocking or
                             non-blocking. By default, blocking read is used.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
          */
-        template <typename T> Event copy(const Buffer<T>& buffer, size_t offset, size_t count, T* ptr, cl_bool blocking = CL_TRUE)
+        template <typename T> Event copy(const Buffer<T>& buffer, size_t offset, size_t count, T* ptr, cl_bool blocking = CL_TRUE, const EventList& wait_list = EventList())
         {
-            cl_event event;
-            cl_int err = clEnqueueReadBuffer(id(), buffer.id(), blocking, offset*sizeof(T), count*sizeof(T), ptr, 0, NULL, &event);
+            cl_event event = 0;
+            cl_int err = clEnqueueReadBuffer(id(), buffer.id(), blocking, offset*sizeof(T), count*sizeof(T), ptr, wait_list.size(), wait_list.data(), eventPointer(event));
             CLPP_CHECK_ERROR(err);
             return Event(event);
         }
@@ -163,12 +269,14 @@ class CommandQueue {
             \param ptr      The host memory chunk where data are read.
             \param blocking Indicates if the write operations are blocking or
                             non-blocking. By default, blocking write is used.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
          */
-        template <typename T> Event copy(const T* ptr, const Buffer<T>& buffer, cl_bool blocking = CL_TRUE)
+        template <typename T> Event copy(const T* ptr, const Buffer<T>& buffer, cl_bool blocking = CL_TRUE, const EventList& wait_list = EventList())
         {
-            cl_event event;
+            cl_event event = 0;
             size_t cb = sizeof(T) * buffer.size();
-            cl_int err = clEnqueueWriteBuffer(id(), buffer.id(), blocking, 0, cb, ptr, 0, NULL, &event);
+            cl_int err = clEnqueueWriteBuffer(id(), buffer.id(), blocking, 0, cb, ptr, wait_list.size(), wait_list.data(), eventPointer(event));
             CLPP_CHECK_ERROR(err);
             return Event(event);
         }
@@ -181,11 +289,13 @@ class CommandQueue {
             \param ptr      The host memory chunk where data are read.
             \param blocking Indicates if the write operations are blocking or
                             non-blocking. By default, blocking write is used.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
          */
-        template <typename T> Event copy(const T* ptr, const Buffer<T>& buffer, size_t offset, size_t count, cl_bool blocking = CL_TRUE)
+        template <typename T> Event copy(const T* ptr, const Buffer<T>& buffer, size_t offset, size_t count, cl_bool blocking = CL_TRUE, const EventList& wait_list = EventList())
         {
-            cl_event event;
-            cl_int err = clEnqueueWriteBuffer(id(), buffer.id(), blocking, offset*sizeof(T), count*sizeof(T), ptr, 0, NULL, &event);
+            cl_event event = 0;
+            cl_int err = clEnqueueWriteBuffer(id(), buffer.id(), blocking, offset*sizeof(T), count*sizeof(T), ptr, wait_list.size(), wait_list.data(), eventPointer(event));
             CLPP_CHECK_ERROR(err);
             return Event(event);
         }
@@ -196,13 +306,15 @@ class CommandQueue {
             \param dst      The destination buffer object.
             \param count    Number of elements to copy. If \a 0 is specified,
                             the size of \a src is used instead.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
          */
-        template <typename T> Event copy(const Buffer<T>& src, const Buffer<T>& dst, size_t count = 0)
+        template <typename T> Event copy(const Buffer<T>& src, const Buffer<T>& dst, size_t count = 0, const EventList& wait_list = EventList())
         {
-            cl_event event;
+            cl_event event = 0;
             if(count == 0)
                 count = src.size();
-            cl_int err = clEnqueueCopyBuffer(id(), src.id(), dst.id(), 0, 0, count*sizeof(T), 0, NULL, &event);
+            cl_int err = clEnqueueCopyBuffer(id(), src.id(), dst.id(), 0, 0, count*sizeof(T), wait_list.size(), wait_list.data(), eventPointer(event));
             CLPP_CHECK_ERROR(err);
             return Event(event);
         }
@@ -214,18 +326,111 @@ class CommandQueue {
             \param dst          The destination buffer object.
             \param dst_offset   Index of the first element to be written.
             \param count        Number of elements to copy.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
          */
-        template <typename T> Event copy(const Buffer<T>& src, size_t src_offset, const Buffer<T>& dst, size_t dst_offset, size_t count)
+        template <typename T> Event copy(const Buffer<T>& src, size_t src_offset, const Buffer<T>& dst, size_t dst_offset, size_t count, const EventList& wait_list = EventList())
         {
-            cl_event event;
+            cl_event event = 0;
             src_offset *= sizeof(T);
             dst_offset *= sizeof(T);
             count *= sizeof(T);
-            cl_int err = clEnqueueCopyBuffer(id(), src.id(), dst.id(), src_offset, dst_offset, count, 0, NULL, &event);
+            cl_int err = clEnqueueCopyBuffer(id(), src.id(), dst.id(), src_offset, dst_offset, count, wait_list.size(), wait_list.data(), eventPointer(event));
             CLPP_CHECK_ERROR(err);
             return Event(event);
         }
 
+        /// Copy data from a buffer view to a host memory chunk.
+        /**
+            \param view         The buffer view where data are read.
+            \param ptr          The host memory chunk where data are written.
+            \param blocking     Indicates if the read operations are blocking
+                                or non-blocking. By default, blocking read is
+                                used.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
+         */
+        template <typename T> Event copy(const BufferView<T>& view, T* ptr, cl_bool blocking = CL_TRUE, const EventList& wait_list = EventList())
+        {
+            return copy(view.parent(), view.parentOffset(), view.size(), ptr, blocking, wait_list);
+        }
+
+        /// Copy data from a host memory chunk to a buffer view.
+        /**
+            \param ptr          The host memory chunk where data are read.
+            \param view         The buffer view where data are written.
+            \param blocking     Indicates if the write operations are
+                                blocking or non-blocking. By default,
+                                blocking write is used.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
+         */
+        template <typename T> Event copy(const T* ptr, const BufferView<T>& view, cl_bool blocking = CL_TRUE, const EventList& wait_list = EventList())
+        {
+            return copy(ptr, view.parent(), view.parentOffset(), view.size(), blocking, wait_list);
+        }
+
+        /// Copy data from a buffer view to another buffer view.
+        /**
+            \param src          The source buffer view.
+            \param dst          The destination buffer view. It must have at
+                                least as many elements as \a src.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
+         */
+        template <typename T> Event copy(const BufferView<T>& src, const BufferView<T>& dst, const EventList& wait_list = EventList())
+        {
+            return copy(src.parent(), src.parentOffset(), dst.parent(), dst.parentOffset(), src.size(), wait_list);
+        }
+
+        /// Map a range of a buffer object into the host address space.
+        /**
+            \param buffer       The buffer object to be mapped.
+            \param offset       The beginning index of items to be mapped.
+            \param count        The number of items to be mapped.
+            \param flags        A bit-field of \c CL_MAP_READ and
+                                \c CL_MAP_WRITE. By default, the range is
+                                mapped for both reading and writing.
+            \param blocking     Indicates if the map operation is blocking or
+                                non-blocking. By default, blocking map is
+                                used. A non-blocking map always creates an
+                                event, even if event output is disabled.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
+
+            \return             The mapped range. The region is unmapped when
+                                the range is destroyed.
+         */
+        template <typename T> MappedRange<T> map(const Buffer<T>& buffer, size_t offset, size_t count, cl_map_flags flags = CL_MAP_READ | CL_MAP_WRITE, cl_bool blocking = CL_TRUE, const EventList& wait_list = EventList())
+        {
+            cl_event event = 0;
+            cl_int err;
+            cl_event* out = blocking ? eventPointer(event) : &event;
+            void* ptr = clEnqueueMapBuffer(id(), buffer.id(), blocking, flags, offset*sizeof(T), count*sizeof(T), wait_list.size(), wait_list.data(), out, &err);
+            CLPP_CHECK_ERROR(err);
+            return MappedRange<T>(id(), buffer, static_cast<T*>(ptr), count, Event(event));
+        }
+
+        /// Map a whole buffer object into the host address space.
+        /**
+            \param buffer       The buffer object to be mapped.
+            \param flags        A bit-field of \c CL_MAP_READ and
+                                \c CL_MAP_WRITE. By default, the buffer is
+                                mapped for both reading and writing.
+            \param blocking     Indicates if the map operation is blocking or
+                                non-blocking. By default, blocking map is
+                                used.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
+
+            \return             The mapped range. The buffer is unmapped when
+                                the range is destroyed.
+         */
+        template <typename T> MappedRange<T> mapAll(const Buffer<T>& buffer, cl_map_flags flags = CL_MAP_READ | CL_MAP_WRITE, cl_bool blocking = CL_TRUE, const EventList& wait_list = EventList())
+        {
+            return map(buffer, 0, buffer.size(), flags, blocking, wait_list);
+        }
+
         /// Execute the kernel function.
         /** This function execute the specified kernel function by 1-D
             work-items.
@@ -235,15 +440,20 @@ class CommandQueue {
             \param local_size   The number of work-items in a work-group.
                                 If \a local_size is 0, an appropriate number
                                 is determined by the OpenCL implementation.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
          */
-        Event exec(Kernel k, size_t global_size, size_t local_size = 0)
+        Event exec(const Kernel& k, size_t global_size, size_t local_size = 0, const EventList& wait_list = EventList())
         {
-            cl_event event;
+            cl_event event = 0;
             cl_int err;
+            checkKernel(k);
+            if(local_size == 0 && my_tuner)
+                tunedLocalSize(k, 1, &global_size, &local_size, true);
             if(local_size == 0)
-                err = clEnqueueNDRangeKernel(id(), k.id(), 1, NULL, &global_size, NULL, 0, NULL, &event);
+                err = clEnqueueNDRangeKernel(id(), k.id(), 1, NULL, &global_size, NULL, wait_list.size(), wait_list.data(), eventPointer(event));
             else
-                err = clEnqueueNDRangeKernel(id(), k.id(), 1, NULL, &global_size, &local_size, 0, NULL, &event);
+                err = clEnqueueNDRangeKernel(id(), k.id(), 1, NULL, &global_size, &local_size, wait_list.size(), wait_list.data(), eventPointer(event));
             CLPP_CHECK_ERROR(err);
             return Event(event);
         }
@@ -259,15 +469,20 @@ class CommandQueue {
                                 If any dimension of \a local_size is 0, an
                                 appropriate number is determined by the OpenCL
                                 implementation.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
          */
-        Event exec(Kernel k, size2 global_size, size2 local_size = size2(0))
+        Event exec(const Kernel& k, size2 global_size, size2 local_size = size2(0), const EventList& wait_list = EventList())
         {
-            cl_event event;
+            cl_event event = 0;
             cl_int err;
+            checkKernel(k);
+            if((local_size.s[0] == 0 || local_size.s[1] == 0) && my_tuner)
+                tunedLocalSize(k, 2, global_size.s, local_size.s, true);
             if(local_size.s[0] == 0 || local_size.s[1] == 0)
-                err = clEnqueueNDRangeKernel(id(), k.id(), 2, NULL, global_size.s, NULL, 0, NULL, &event);
+                err = clEnqueueNDRangeKernel(id(), k.id(), 2, NULL, global_size.s, NULL, wait_list.size(), wait_list.data(), eventPointer(event));
             else
-                err = clEnqueueNDRangeKernel(id(), k.id(), 2, NULL, global_size.s, local_size.s, 0, NULL, &event);
+                err = clEnqueueNDRangeKernel(id(), k.id(), 2, NULL, global_size.s, local_size.s, wait_list.size(), wait_list.data(), eventPointer(event));
             CLPP_CHECK_ERROR(err);
             return Event(event);
         }
@@ -283,29 +498,206 @@ class CommandQueue {
                                 If any dimension of \a local_size is 0, an
                                 appropriate number is determined by the OpenCL
                                 implementation.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
          */
-        Event exec(Kernel k, size3 global_size, size3 local_size = size3(0))
+        Event exec(const Kernel& k, size3 global_size, size3 local_size = size3(0), const EventList& wait_list = EventList())
         {
-            cl_event event;
+            cl_event event = 0;
             cl_int err;
+            checkKernel(k);
+            if((local_size.s[0] == 0 || local_size.s[1] == 0 || local_size.s[2] == 0) && my_tuner)
+                tunedLocalSize(k, 3, global_size.s, local_size.s, true);
             if(local_size.s[0] == 0 || local_size.s[1] == 0 || local_size.s[2] == 0)
-                err = clEnqueueNDRangeKernel(id(), k.id(), 3, NULL, global_size.s, NULL, 0, NULL, &event);
+                err = clEnqueueNDRangeKernel(id(), k.id(), 3, NULL, global_size.s, NULL, wait_list.size(), wait_list.data(), eventPointer(event));
             else
-                err = clEnqueueNDRangeKernel(id(), k.id(), 3, NULL, global_size.s, local_size.s, 0, NULL, &event);
+                err = clEnqueueNDRangeKernel(id(), k.id(), 3, NULL, global_size.s, local_size.s, wait_list.size(), wait_list.data(), eventPointer(event));
+            CLPP_CHECK_ERROR(err);
+            return Event(event);
+        }
+
+#ifdef CL_VERSION_1_1
+        /// Execute the kernel function over a range starting at an offset.
+        /** This function execute the specified kernel function by 1-D
+            work-items whose global IDs start at \a global_offset instead of
+            0, e.g. to execute a part of a larger range.
+
+            \param k                The specified kernel function.
+            \param global_offset    The global ID of the first work-item.
+            \param global_size      The number of global work-items.
+            \param local_size       The number of work-items in a work-group.
+                                    If \a local_size is 0, an appropriate
+                                    number is determined by the OpenCL
+                                    implementation.
+            \param wait_list        Events that need to complete before this
+                                    command can be executed.
+         */
+        Event execOffset(const Kernel& k, size_t global_offset, size_t global_size, size_t local_size = 0, const EventList& wait_list = EventList())
+        {
+            cl_event event = 0;
+            checkKernel(k);
+            cl_int err = clEnqueueNDRangeKernel(id(), k.id(), 1, &global_offset, &global_size, local_size == 0 ? NULL : &local_size,
+                                                wait_list.size(), wait_list.data(), eventPointer(event));
+            CLPP_CHECK_ERROR(err);
+            return Event(event);
+        }
+
+        /// Execute the kernel function over a range starting at an offset.
+        /** This function execute the specified kernel function by 2-D
+            work-items. See execOffset(const Kernel&, size_t, size_t, size_t, const EventList&).
+         */
+        Event execOffset(const Kernel& k, size2 global_offset, size2 global_size, size2 local_size = size2(0), const EventList& wait_list = EventList())
+        {
+            cl_event event = 0;
+            checkKernel(k);
+            bool no_local = local_size.s[0] == 0 || local_size.s[1] == 0;
+            cl_int err = clEnqueueNDRangeKernel(id(), k.id(), 2, global_offset.s, global_size.s, no_local ? NULL : local_size.s,
+                                                wait_list.size(), wait_list.data(), eventPointer(event));
             CLPP_CHECK_ERROR(err);
             return Event(event);
         }
+#endif
+
+        /// Execute the kernel function with an automatically chosen work-group size.
+        /** This function execute the specified kernel function by 1-D
+            work-items. The work-group size is chosen by
+            Kernel::selectLocalSize for the device of this queue, and the
+            global size is padded to a multiple of it. The kernel must
+            ignore work-items beyond \a global_size.
+
+            \param k            The specified kernel function.
+            \param global_size  The number of global work-items.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
+         */
+        Event execAuto(const Kernel& k, size_t global_size, const EventList& wait_list = EventList())
+        {
+            size_t local_size;
+            if(!tunedLocalSize(k, 1, &global_size, &local_size, false))
+                k.selectLocalSize(device(), 1, &global_size, &local_size);
+            return exec(k, padSize(global_size, local_size), local_size, wait_list);
+        }
+
+        /// Execute the kernel function with an automatically chosen work-group size.
+        /** This function execute the specified kernel function by 2-D
+            work-items. See execAuto(const Kernel&, size_t, const EventList&).
+
+            \param k            The specified kernel function.
+            \param global_size  The number of global work-items in each
+                                dimension.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
+         */
+        Event execAuto(const Kernel& k, size2 global_size, const EventList& wait_list = EventList())
+        {
+            size2 local_size;
+            if(!tunedLocalSize(k, 2, global_size.s, local_size.s, false))
+                k.selectLocalSize(device(), 2, global_size.s, local_size.s);
+            size2 padded(padSize(global_size.s[0], local_size.s[0]), padSize(global_size.s[1], local_size.s[1]));
+            return exec(k, padded, local_size, wait_list);
+        }
+
+        /// Execute the kernel function with an automatically chosen work-group size.
+        /** This function execute the specified kernel function by 3-D
+            work-items. See execAuto(const Kernel&, size_t, const EventList&).
+
+            \param k            The specified kernel function.
+            \param global_size  The number of global work-items in each
+                                dimension.
+            \param wait_list    Events that need to complete before this
+                                command can be executed.
+         */
+        Event execAuto(const Kernel& k, size3 global_size, const EventList& wait_list = EventList())
+        {
+            size3 local_size;
+            if(!tunedLocalSize(k, 3, global_size.s, local_size.s, false))
+                k.selectLocalSize(device(), 3, global_size.s, local_size.s);
+            size3 padded(padSize(global_size.s[0], local_size.s[0]),
+                         padSize(global_size.s[1], local_size.s[1]),
+                         padSize(global_size.s[2], local_size.s[2]));
+            return exec(k, padded, local_size, wait_list);
+        }
+
+        /// Round a global size up to a multiple of a work-group size.
+        /** This is the global size used by execAuto().
+
+            \param global_size  The number of global work-items.
+            \param local_size   The work-group size. It must not be 0.
+
+            \return             The smallest multiple of \a local_size which
+                                is not less than \a global_size.
+         */
+        static size_t padSize(size_t global_size, size_t local_size)
+        {
+            return (global_size + local_size - 1) / local_size * local_size;
+        }
+
+        /// Insert a marker into the command queue.
+        /** If \a wait_list is empty, the returned event is complete when
+            all previously enqueued commands are complete. Otherwise it is
+            complete when all events in \a wait_list are complete.
 
-        Event marker()
+            \param wait_list    Events that need to complete before the
+                                marker is complete.
+         */
+        Event marker(const EventList& wait_list = EventList())
         {
             cl_event event;
-            cl_int err = clEnqueueMarker(id(), &event);
+            cl_int err;
+#ifdef CL_VERSION_1_2
+            err = clEnqueueMarkerWithWaitList(id(), wait_list.size(), wait_list.data(), &event);
+#else
+            if(!wait_list.empty())
+                CLPP_CHECK_ERROR( clEnqueueWaitForEvents(id(), wait_list.size(), wait_list.data()) );
+            err = clEnqueueMarker(id(), &event);
+#endif
             CLPP_CHECK_ERROR(err);
             return Event(event);
         }
 
     private:
+        // Fill local_size from the attached tuner. If exact is true, the
+        // tuned size is only used if it divides the global size.
+        bool tunedLocalSize(const Kernel& k, cl_uint dim, const size_t* global_size, size_t* local_size, bool exact) const
+        {
+            KernelTuner::Config config;
+            if(!my_tuner || !my_tuner->lookup(k.name(), my_device_name, dim, global_size, config))
+                return false;
+            for(cl_uint d = 0; d < dim; ++d)
+                if(config.local_size.s[d] == 0 || (exact && global_size[d] % config.local_size.s[d] != 0))
+                    return false;
+            for(cl_uint d = 0; d < dim; ++d)
+                local_size[d] = config.local_size.s[d];
+            return true;
+        }
+
+        // Validate the local memory of kernels with LocalMemory arguments.
+        void checkKernel(const Kernel& k) const
+        {
+            if(k.localArgSize() != 0)
+                k.checkLocalMemory(my_device);
+        }
+
+        static Device queryDevice(cl_command_queue q)
+        {
+            cl_device_id d = 0;
+            if(q != 0){
+                cl_int err = clGetCommandQueueInfo(q, CL_QUEUE_DEVICE, sizeof(d), &d, NULL);
+                CLPP_CHECK_ERROR(err);
+            }
+            return Device(d);
+        }
+
+        cl_event* eventPointer(cl_event& event) const
+        {
+            return my_event_output ? &event : NULL;
+        }
+
         Resource<cl_command_queue> my_resource;
+        Device my_device;
+        bool my_event_output;
+        std::shared_ptr<const KernelTuner> my_tuner;
+        std::string my_device_name;
 }; // class CommandQueue
 
 } // namespace clpp
@@ -0,0 +1,429 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_COMMANDRECORDING_HPP
+#define CLPP_COMMANDRECORDING_HPP
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "error.hpp"
+#include "size.hpp"
+#include "commandqueue.hpp"
+#include "buffer.hpp"
+#include "kernel.hpp"
+#include "event.hpp"
+
+#ifdef CLPP_ENABLE_COMMAND_BUFFER
+#if defined(__APPLE__) || defined(__MACOSX)
+#include <OpenCL/cl_ext.h>
+#else
+#include <CL/cl_ext.h>
+#endif
+// The extension is only used if the headers declare it.
+#if defined(cl_khr_command_buffer) && defined(CL_VERSION_1_2)
+#define CLPP_COMMAND_BUFFER
+#endif
+#endif
+
+namespace clpp {
+
+/// A recorded sequence of commands which can be replayed in one call.
+/** A recording captures kernel executions and copies, with their kernel
+    arguments and sizes resolved when they are recorded, e.g.
+
+    \code
+    CommandRecording frame(queue);
+    k.setArgs(input, output, cl_int(0));
+    frame.copy(&host_input[0], input);
+    size_t step = frame.exec(k, n, 64);
+    frame.copy(output, &host_output[0]);
+
+    for(int i = 0; ; ++i){
+        frame.setArg(step, 2, cl_int(i));   // patch an argument
+        frame.replay().wait();
+    }
+    \endcode
+
+    Each recorded kernel execution gets its own clone of the kernel with
+    the arguments bound at that time, so later changes to the original
+    kernel don't affect the recording, and the same kernel can be recorded
+    several times with different arguments. Arguments are only patched by
+    setArg(), through the argument cache of Kernel::setArg.
+
+    Replaying enqueues the commands directly, in order, without the checks
+    done by CommandQueue, and requests only the event of the last command.
+    Host memory given to copies must stay valid while the recording is
+    replayed. Buffers given to copies and to setArg() are kept alive by the
+    recording, but kernels don't keep their arguments alive, so buffers
+    bound to a kernel before it is recorded must outlive all replays.
+
+    If \c CLPP_ENABLE_COMMAND_BUFFER is defined, the OpenCL headers declare
+    the \c cl_khr_command_buffer extension and the device supports it, a
+    recording of kernel executions and buffer-to-buffer copies is replayed
+    by \c clEnqueueCommandBufferKHR. The
+    command buffer is finalized at the first replay, and again at the first
+    replay after an argument is patched. Recordings with host copies, or
+    devices without the extension, use the software replay. The extension
+    is provisional, so the support is opt-in and written for revision 0.9.5
+    of its API.
+ */
+class CommandRecording {
+    public:
+        /// Construct an empty recording.
+        /**
+            \param queue    The command queue where the recording is
+                            replayed.
+         */
+        explicit CommandRecording(const CommandQueue& queue) : my_queue(queue)
+        {}
+
+        /// Record a kernel execution by 1-D work-items.
+        /** See CommandQueue::exec(const Kernel&, size_t, size_t, const EventList&).
+
+            \return     The index of the command, used to patch arguments.
+         */
+        size_t exec(const Kernel& k, size_t global_size, size_t local_size = 0)
+        {
+            return record(k, 1, size3(global_size, 1, 1), size3(local_size, 1, 1));
+        }
+
+        /// Record a kernel execution by 2-D work-items.
+        size_t exec(const Kernel& k, size2 global_size, size2 local_size = size2(0))
+        {
+            return record(k, 2, size3(global_size.s[0], global_size.s[1], 1), size3(local_size.s[0], local_size.s[1], 1));
+        }
+
+        /// Record a kernel execution by 3-D work-items.
+        size_t exec(const Kernel& k, size3 global_size, size3 local_size = size3(0))
+        {
+            return record(k, 3, global_size, local_size);
+        }
+
+        /// Record a non-blocking write of a whole buffer from host memory.
+        template <typename T> size_t copy(const T* ptr, const Buffer<T>& buffer)
+        {
+            Command c(WRITE);
+            c.keep.push_back(buffer);
+            c.dst = buffer.id();
+            c.host_src = ptr;
+            c.bytes = buffer.size()*sizeof(T);
+            return append(c);
+        }
+
+        /// Record a non-blocking read of a whole buffer into host memory.
+        template <typename T> size_t copy(const Buffer<T>& buffer, T* ptr)
+        {
+            Command c(READ);
+            c.keep.push_back(buffer);
+            c.src = buffer.id();
+            c.host_dst = ptr;
+            c.bytes = buffer.size()*sizeof(T);
+            return append(c);
+        }
+
+        /// Record a copy between buffers.
+        /**
+            \param src      The source buffer.
+            \param dst      The destination buffer.
+            \param count    The number of elements. If it is 0, the whole
+                            source buffer is copied.
+         */
+        template <typename T> size_t copy(const Buffer<T>& src, const Buffer<T>& dst, size_t count = 0)
+        {
+            Command c(COPY);
+            c.keep.push_back(src);
+            c.keep.push_back(dst);
+            c.src = src.id();
+            c.dst = dst.id();
+            c.bytes = (count == 0 ? src.size() : count)*sizeof(T);
+            return append(c);
+        }
+
+        /// Patch an argument of a recorded kernel execution.
+        /**
+            \param command  The index returned by exec().
+            \param index    The index of the argument.
+            \param value    The new value.
+
+            \throw Error    \c CL_INVALID_VALUE if \a command is not the index
+                            of a recorded kernel execution.
+         */
+        template <typename T> void setArg(size_t command, cl_uint index, const T& value)
+        {
+            execCommand(command).kernel.setArg(index, value);
+#ifdef CLPP_COMMAND_BUFFER
+            my_command_buffer.reset();
+#endif
+        }
+
+        /// Patch a buffer argument of a recorded kernel execution.
+        /** The buffer is kept alive by the recording until the argument is
+            patched again.
+         */
+        template <typename T> void setArg(size_t command, cl_uint index, const Buffer<T>& buffer)
+        {
+            Command& c = execCommand(command);
+            c.kernel.setArg(index, buffer);
+            keepArg(c, index, buffer);
+#ifdef CLPP_COMMAND_BUFFER
+            my_command_buffer.reset();
+#endif
+        }
+
+        /// Patch a buffer argument of a recorded kernel execution by a view.
+        /** See Kernel::setArg(cl_uint, const BufferView<T>&).
+         */
+        template <typename T> void setArg(size_t command, cl_uint index, const BufferView<T>& view)
+        {
+            setArg(command, index, view.buffer());
+        }
+
+        /// Get the kernel of a recorded kernel execution.
+        /** Arguments changed directly on the returned kernel are used by
+            the software replay, but not by a command buffer which is already
+            finalized. Please use setArg() to patch arguments.
+
+            \throw Error    \c CL_INVALID_VALUE if \a command is not the index
+                            of a recorded kernel execution.
+         */
+        Kernel& kernel(size_t command)
+        {
+            return execCommand(command).kernel;
+        }
+
+        /// Get the number of recorded commands.
+        size_t size() const
+        {
+            return my_commands.size();
+        }
+
+        /// Check if the recording is replayed by a command buffer.
+        /** The command buffer is created at the first replay, so this
+            function is only meaningful after it.
+         */
+        bool usesCommandBuffer() const
+        {
+#ifdef CLPP_COMMAND_BUFFER
+            return my_command_buffer.get() != 0;
+#else
+            return false;
+#endif
+        }
+
+        /// Replay the recorded commands.
+        /**
+            \param wait_list    Events that need to complete before the first
+                                command can be executed.
+
+            \return             The event of the last command, or a null
+                                event if the recording is empty.
+         */
+        Event replay(const EventList& wait_list = EventList())
+        {
+#ifdef CLPP_COMMAND_BUFFER
+            if(!my_command_buffer && my_command_buffer_supported)
+                my_command_buffer = createCommandBuffer();
+            if(my_command_buffer){
+                cl_event event;
+                cl_command_queue q = my_queue.id();
+                cl_int err = my_command_buffer->enqueue(1, &q, my_command_buffer->id, wait_list.size(), wait_list.data(), &event);
+                CLPP_CHECK_ERROR(err);
+                return Event(event);
+            }
+#endif
+            cl_command_queue q = my_queue.id();
+            cl_event event = 0;
+            for(size_t i = 0; i < my_commands.size(); ++i){
+                const Command& c = my_commands[i];
+                cl_uint num_wait = i == 0 ? wait_list.size() : 0;
+                const cl_event* wait = i == 0 ? wait_list.data() : NULL;
+                cl_event* out = i + 1 == my_commands.size() ? &event : NULL;
+                cl_int err;
+                switch(c.type){
+                    case EXEC:
+                        err = clEnqueueNDRangeKernel(q, c.kernel.id(), c.dim, NULL, c.global.s, c.has_local ? c.local.s : NULL, num_wait, wait, out);
+                        break;
+                    case WRITE:
+                        err = clEnqueueWriteBuffer(q, c.dst, CL_FALSE, 0, c.bytes, c.host_src, num_wait, wait, out);
+                        break;
+                    case READ:
+                        err = clEnqueueReadBuffer(q, c.src, CL_FALSE, 0, c.bytes, c.host_dst, num_wait, wait, out);
+                        break;
+                    default:
+                        err = clEnqueueCopyBuffer(q, c.src, c.dst, 0, 0, c.bytes, num_wait, wait, out);
+                        break;
+                }
+                CLPP_CHECK_ERROR(err);
+            }
+            return Event(event);
+        }
+
+    private:
+        enum Type { EXEC, WRITE, READ, COPY };
+
+        struct Command {
+            explicit Command(Type t)
+                : type(t), dim(0), has_local(false), src(0), dst(0), host_src(NULL), host_dst(NULL), bytes(0)
+            {}
+
+            Type type;
+
+            // Kernel executions
+            Kernel kernel;
+            cl_uint dim;
+            size3 global;
+            size3 local;
+            bool has_local;
+
+            // Buffers patched by setArg(), by argument index
+            std::vector< std::pair<cl_uint, Memory> > args;
+
+            // Copies
+            std::vector<Memory> keep;
+            cl_mem src;
+            cl_mem dst;
+            const void* host_src;
+            void* host_dst;
+            size_t bytes;
+        };
+
+        size_t record(const Kernel& k, cl_uint dim, size3 global_size, size3 local_size)
+        {
+            // Validate once, as CommandQueue::exec would on every launch.
+            if(k.localArgSize() != 0)
+                k.checkLocalMemory(my_queue.device());
+
+            Command c(EXEC);
+            c.kernel = k.clone();
+            c.dim = dim;
+            c.global = global_size;
+            c.local = local_size;
+            c.has_local = true;
+            for(cl_uint d = 0; d < dim; ++d)
+                if(local_size.s[d] == 0)
+                    c.has_local = false;
+            return append(c);
+        }
+
+        // Get a recorded kernel execution by its index.
+        Command& execCommand(size_t command)
+        {
+            if(command >= my_commands.size() || my_commands[command].type != EXEC)
+                CLPP_CHECK_ERROR(CL_INVALID_VALUE);
+            return my_commands[command];
+        }
+
+        // Keep the buffer patched at an argument index, instead of the
+        // one patched before.
+        static void keepArg(Command& c, cl_uint index, const Memory& mem)
+        {
+            for(size_t i = 0; i < c.args.size(); ++i){
+                if(c.args[i].first == index){
+                    c.args[i].second = mem;
+                    return;
+                }
+            }
+            c.args.push_back(std::make_pair(index, mem));
+        }
+
+        size_t append(const Command& c)
+        {
+            my_commands.push_back(c);
+#ifdef CLPP_COMMAND_BUFFER
+            my_command_buffer.reset();
+            if(c.type == WRITE || c.type == READ)
+                my_command_buffer_supported = false;
+#endif
+            return my_commands.size() - 1;
+        }
+
+#ifdef CLPP_COMMAND_BUFFER
+        // A finalized command buffer and the extension functions used with
+        // it.
+        struct CommandBuffer {
+            CommandBuffer() : id(0), release(0), enqueue(0) {}
+
+            ~CommandBuffer()
+            {
+                if(id != 0)
+                    release(id);
+            }
+
+            cl_command_buffer_khr id;
+            clReleaseCommandBufferKHR_fn release;
+            clEnqueueCommandBufferKHR_fn enqueue;
+        };
+
+        template <typename F> static F extension(cl_platform_id platform, const char* name)
+        {
+            return reinterpret_cast<F>(clGetExtensionFunctionAddressForPlatform(platform, name));
+        }
+
+        // Record the commands into a command buffer. A null pointer is
+        // returned, and the software replay is used from then on, if the
+        // extension is unavailable or any step fails.
+        std::shared_ptr<CommandBuffer> createCommandBuffer()
+        {
+            std::shared_ptr<CommandBuffer> result;
+            my_command_buffer_supported = false;
+            if(my_commands.empty() || my_queue.device().extensions().find("cl_khr_command_buffer") == std::string::npos)
+                return result;
+
+            cl_platform_id platform = my_queue.device().getInfo<cl_platform_id>(CL_DEVICE_PLATFORM);
+            clCreateCommandBufferKHR_fn create = extension<clCreateCommandBufferKHR_fn>(platform, "clCreateCommandBufferKHR");
+            clFinalizeCommandBufferKHR_fn finalize = extension<clFinalizeCommandBufferKHR_fn>(platform, "clFinalizeCommandBufferKHR");
+            clCommandNDRangeKernelKHR_fn ndrange = extension<clCommandNDRangeKernelKHR_fn>(platform, "clCommandNDRangeKernelKHR");
+            clCommandCopyBufferKHR_fn copy = extension<clCommandCopyBufferKHR_fn>(platform, "clCommandCopyBufferKHR");
+            std::shared_ptr<CommandBuffer> cb(new CommandBuffer);
+            cb->release = extension<clReleaseCommandBufferKHR_fn>(platform, "clReleaseCommandBufferKHR");
+            cb->enqueue = extension<clEnqueueCommandBufferKHR_fn>(platform, "clEnqueueCommandBufferKHR");
+            if(!create || !finalize || !ndrange || !copy || !cb->release || !cb->enqueue)
+                return result;
+
+            cl_command_queue q = my_queue.id();
+            cl_int err;
+            cb->id = create(1, &q, NULL, &err);
+            if(err != CL_SUCCESS)
+                return result;
+
+            // Commands in a command buffer are ordered by sync points; each
+            // command waits for the previous one, as in an in-order queue.
+            cl_sync_point_khr previous = 0;
+            for(size_t i = 0; i < my_commands.size(); ++i){
+                const Command& c = my_commands[i];
+                cl_sync_point_khr point;
+                cl_uint num_wait = i == 0 ? 0 : 1;
+                if(c.type == EXEC)
+                    err = ndrange(cb->id, NULL, NULL, c.kernel.id(), c.dim, NULL, c.global.s, c.has_local ? c.local.s : NULL,
+                                  num_wait, &previous, &point, NULL);
+                else
+                    err = copy(cb->id, NULL, NULL, c.src, c.dst, 0, 0, c.bytes, num_wait, &previous, &point, NULL);
+                if(err != CL_SUCCESS)
+                    return result;
+                previous = point;
+            }
+            if(finalize(cb->id) != CL_SUCCESS)
+                return result;
+
+            my_command_buffer_supported = true;
+            return cb;
+        }
+#endif
+
+        CommandQueue my_queue;
+        std::vector<Command> my_commands;
+#ifdef CLPP_COMMAND_BUFFER
+        std::shared_ptr<CommandBuffer> my_command_buffer;
+        bool my_command_buffer_supported = true;
+#endif
+}; // class CommandRecording
+
+} // namespace clpp
+
+#endif // CLPP_COMMANDRECORDING_HPP
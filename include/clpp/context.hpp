@@ -6,8 +6,17 @@
 #ifndef CLPP_CONTEXT_HPP
 #define CLPP_CONTEXT_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
+#include <memory>
 
 #include "platform.hpp"
 #include "device.hpp"
@@ -15,6 +24,9 @@
 #include "buffer.hpp"
 #include "image.hpp"
 #include "program.hpp"
+#include "pool.hpp"
+#include "programcache.hpp"
+#include "embedded.hpp"
 #include "error.hpp"
 
 namespace clpp {
@@ -58,7 +70,7 @@ class Context {
         /**
             \param device_list  The list of devices to be used in this context.
          */
-        Context(DeviceList device_list) : my_devices(device_list)
+        Context(const DeviceList& device_list) : my_devices(device_list)
         {
             initByDevices();
         }
@@ -72,6 +84,22 @@ class Context {
             initByDevices();
         }
 
+#ifdef CL_VERSION_1_2
+        /// Construct the context by the sub-devices of a device.
+        /** The device is partitioned by Device::partition, and each
+            sub-device gets its own command queue, e.g. queue(0) for the
+            first NUMA node and queue(1) for the second one. The sub-devices
+            are released with the context.
+
+            \param device       The device to be partitioned.
+            \param partition    The way to partition \a device.
+         */
+        Context(Device device, const Partition& partition) : my_devices(device.partition(partition))
+        {
+            initByDevices();
+        }
+#endif
+
         /// Get the cl_context object created by OpenCL API.
         /**
             \return     The \c cl_context object created by OpenCL API.
@@ -118,14 +146,79 @@ class Context {
 
             \return         A buffer object which has \c size elements in type
                             \c T.
+
+            \sa enableBufferPool()
          */
         template <typename T>
         Buffer<T> createBuffer(size_t size, cl_mem_flags flags = CL_MEM_READ_WRITE, T* ptr = NULL)
         {
+            if(my_pool && BufferPool::poolable(flags, ptr)){
+                cl_mem mem;
+                std::shared_ptr<void> lease = my_pool->acquire(size*sizeof(T), flags, mem);
+                return Buffer<T>(mem, size, flags, lease);
+            }
+
             cl_int err = 0;
             cl_mem mem = clCreateBuffer(id(), flags, size*sizeof(T), ptr, &err);
             CLPP_CHECK_ERROR(err);
-            return Buffer<T>(mem);
+            return Buffer<T>(mem, size, flags);
+        }
+
+        /// Enable the buffer pool of this context.
+        /** When the buffer pool is enabled, createBuffer recycles memory
+            objects of released buffers which have the same size class and
+            memory flags. Buffers created with a host pointer, or with
+            \c CL_MEM_USE_HOST_PTR or \c CL_MEM_COPY_HOST_PTR, are never
+            pooled.
+
+            Note that a pooled buffer may be larger than requested. Its
+            contents are not cleared when it is recycled. The memory of a
+            destroyed buffer is only recycled once the commands enqueued
+            before on the command queues of this context are complete;
+            commands on other command queues must be finished before a
+            pooled buffer is destroyed.
+
+            \param max_pooled_bytes The maximum number of bytes kept by idle
+                                    memory objects in the pool.
+         */
+        void enableBufferPool(size_t max_pooled_bytes = 256*1024*1024)
+        {
+            if(!my_pool){
+                std::vector<cl_command_queue> queues;
+                for(size_t i = 0; i < my_queues.size(); ++i)
+                    queues.push_back(my_queues[i].id());
+                my_pool.reset(new BufferPool(id(), max_pooled_bytes, queues));
+            }
+        }
+
+        /// Disable the buffer pool of this context.
+        /** Idle memory objects are released once every pooled buffer still
+            in use has been destroyed.
+         */
+        void disableBufferPool()
+        {
+            my_pool.reset();
+        }
+
+        /// Release all idle memory objects in the buffer pool.
+        void trimBufferPool()
+        {
+            if(my_pool)
+                my_pool->trim();
+        }
+
+        /// Get the usage counters of the buffer pool.
+        /**
+            \return     The counters of the buffer pool. All counters are
+                        zero if the pool is not enabled.
+         */
+        BufferPool::Statistics bufferPoolStatistics() const
+        {
+            if(my_pool)
+                return my_pool->statistics();
+
+            BufferPool::Statistics s = {0, 0, 0, 0};
+            return s;
         }
 
         /// Create a 2D image object.
@@ -136,20 +229,20 @@ class Context {
             format.image_channel_order = O;
             format.image_channel_data_type = T;
             cl_int err;
-            cl_mem mem = clCreateImage2D(id(), flags, &format, size.s[0], size.s[1], pitch, host_ptr, err);
+            cl_mem mem = clCreateImage2D(id(), flags, &format, size.s[0], size.s[1], pitch, host_ptr, &err);
             CLPP_CHECK_ERROR(err);
             return Image2D(mem);
         }
 
         /// Create a 3D image object.
         template <cl_channel_order O, cl_channel_type T>
-        Image2D createImage(size3 size, cl_mem_flags flags = CL_MEM_READ_WRITE, typename ChannelType<T>::Type* host_ptr = NULL, size_t row_pitch = 0, size_t slice_pitch = 0)
+        Image3D createImage(size3 size, cl_mem_flags flags = CL_MEM_READ_WRITE, typename ChannelType<T>::Type* host_ptr = NULL, size_t row_pitch = 0, size_t slice_pitch = 0)
         {
             cl_image_format format;
             format.image_channel_order = O;
             format.image_channel_data_type = T;
             cl_int err;
-            cl_mem mem = clCreateImage3D(id(), flags, &format, size.s[0], size.s[1], size.s[2], row_pitch, slice_pitch, host_ptr, err);
+            cl_mem mem = clCreateImage3D(id(), flags, &format, size.s[0], size.s[1], size.s[2], row_pitch, slice_pitch, host_ptr, &err);
             CLPP_CHECK_ERROR(err);
             return Image3D(mem);
         }
@@ -161,15 +254,95 @@ class Context {
 
             \return         The program object. The program is automatically
                             built for all devices associated with the context.
+
+            \sa enableProgramCache()
          */
         Program readProgramSource(const char* source, const char* options = NULL)
         {
-            cl_int err;
-            cl_program pid = clCreateProgramWithSource(id(), 1, const_cast<const char**>(&source), NULL, &err);
-            CLPP_CHECK_ERROR(err);
-			Program p(pid);
-			p.build(my_devices, options);
-            return p;
+            return buildSource(id(), my_devices, my_program_cache.get(), source, options);
+        }
+
+        /// Create a program object from an embedded source.
+        /** Unlike readProgramSourceFile, the source is compiled into the
+            executable by \c tools/embedcl.lua, so no file is read. The
+            program cache uses the hash computed by the generator.
+
+            \param source   The embedded source, e.g. from
+                            EmbeddedSources::get().
+            \param options  Additional compiler options for this program.
+
+            \return         The program object. The program is automatically
+                            built for all devices associated with the context.
+         */
+        Program readProgramSource(const EmbeddedSource& source, const char* options = NULL)
+        {
+            if(my_program_cache)
+                return my_program_cache->build(id(), my_devices, source.source, source.hash, options);
+
+            return readProgramSource(source.source, options);
+        }
+
+        /// Create a program object and build it without blocking.
+        /** Without the program cache, the build is started by
+            Program::buildAsync. With the program cache, the cache lookup
+            and the build are done by a background thread.
+
+            \param source   The program source code. It must be null-terminated.
+            \param options  Additional compiler options for this program.
+
+            \return         The future of the program built for all devices
+                            associated with the context.
+
+            \sa prebuild()
+         */
+        std::future<Program> readProgramSourceAsync(const char* source, const char* options = NULL)
+        {
+            if(my_program_cache)
+                return std::move(prebuild(std::vector<std::string>(1, source), options, 1)[0]);
+
+            return createProgram(id(), source).buildAsync(my_devices, options);
+        }
+
+        /// Build many programs concurrently in the background.
+        /** The sources are built by worker threads, so a service can start
+            while its programs are compiled, and wait for each program only
+            when it is first needed, e.g.
+
+            \code
+            std::vector< std::future<Program> > programs = context.prebuild(sources);
+            // ... start accepting requests ...
+            Kernel k = programs[0].get().kernel("main");
+            \endcode
+
+            The program cache is used if it is enabled. The worker threads
+            are shared by all contexts, and no more than one per hardware
+            thread is started, however many builds are requested. They exit
+            when no builds are left; the futures should be waited for before
+            the application exits.
+
+            \param sources     The program source codes.
+            \param options     Additional compiler options for all programs.
+            \param num_threads The maximum number of these sources built at
+                                once. By default, one per hardware thread.
+
+            \return            The futures of the programs, in the order of
+                                \a sources. A future holds a
+                                Program::BuildError if its build fails.
+         */
+        std::vector< std::future<Program> > prebuild(const std::vector<std::string>& sources, const char* options = NULL, size_t num_threads = 0)
+        {
+            std::shared_ptr<PrebuildJob> job(new PrebuildJob(my_resource, my_devices, my_program_cache, sources, options));
+            std::vector< std::future<Program> > result;
+            result.reserve(sources.size());
+            for(size_t i = 0; i < sources.size(); ++i)
+                result.push_back(job->promises[i].get_future());
+
+            if(num_threads == 0)
+                num_threads = BuildWorkers::instance().maxThreads();
+            num_threads = std::min(num_threads, sources.size());
+            for(size_t i = 0; i < num_threads; ++i)
+                BuildWorkers::instance().submit(std::bind(&PrebuildJob::run, job));
+            return result;
         }
 
         /// Create a program object.
@@ -180,6 +353,8 @@ class Context {
 
             \return         The program object. The program is automatically
                             built for all devices associated with the context.
+
+            \sa readProgramSource(const EmbeddedSource&, const char*)
          */
         Program readProgramSourceFile(const char* filename, const char* options = NULL)
         {
@@ -191,6 +366,40 @@ class Context {
             return readProgramSource(&src[0], options);
         }
 
+        /// Enable the persistent program binary cache.
+        /** When the program cache is enabled, readProgramSource and
+            readProgramSourceFile store the binaries of built programs in
+            \a directory, and load them instead of compiling the source again
+            if the source, options, devices and drivers are unchanged.
+
+            \param directory    The directory where program binaries are
+                                stored. It must exist and be writable.
+         */
+        void enableProgramCache(const std::string& directory)
+        {
+            my_program_cache.reset(new ProgramCache(directory));
+        }
+
+        /// Disable the program binary cache.
+        void disableProgramCache()
+        {
+            my_program_cache.reset();
+        }
+
+        /// Get the usage counters of the program cache.
+        /**
+            \return     The counters of the program cache. All counters are
+                        zero if the cache is not enabled.
+         */
+        ProgramCache::Statistics programCacheStatistics() const
+        {
+            if(my_program_cache)
+                return my_program_cache->statistics();
+
+            ProgramCache::Statistics s = {0, 0, 0, 0, 0};
+            return s;
+        }
+
     private:
         void initByPlatform(cl_platform_id platform, cl_device_type type)
         {
@@ -248,19 +457,130 @@ class Context {
             initQueues();
         }
 
+        // The sources and results of prebuild(), shared by its workers.
+        struct PrebuildJob {
+            PrebuildJob(const Resource<cl_context>& c, const DeviceList& d, const std::shared_ptr<ProgramCache>& pc,
+                        const std::vector<std::string>& s, const char* o)
+                : context(c), devices(d), cache(pc), sources(s), has_options(o != NULL),
+                  options(o ? o : ""), promises(s.size()), next(0)
+            {}
+
+            void run()
+            {
+                for(size_t i = next++; i < sources.size(); i = next++){
+                    try{
+                        promises[i].set_value(buildSource(*context, devices, cache.get(), sources[i].c_str(),
+                                                          has_options ? options.c_str() : NULL));
+                    }catch(...){
+                        promises[i].set_exception(std::current_exception());
+                    }
+                }
+            }
+
+            Resource<cl_context> context;
+            DeviceList devices;
+            std::shared_ptr<ProgramCache> cache;
+            std::vector<std::string> sources;
+            bool has_options;
+            std::string options;
+            std::vector< std::promise<Program> > promises;
+            std::atomic<size_t> next;
+        };
+
+        // The worker threads of prebuild(), shared by all contexts. A thread
+        // is started for a task if fewer than maxThreads() are running, and
+        // exits when no tasks are queued. The workers are never destroyed,
+        // since they may still run while static objects are destroyed.
+        class BuildWorkers {
+            public:
+                static BuildWorkers& instance()
+                {
+                    static BuildWorkers* workers = new BuildWorkers;
+                    return *workers;
+                }
+
+                size_t maxThreads() const
+                {
+                    return my_max_threads;
+                }
+
+                void submit(const std::function<void()>& task)
+                {
+                    std::lock_guard<std::mutex> lock(my_mutex);
+                    my_tasks.push_back(task);
+                    if(my_running < my_max_threads){
+                        try{
+                            std::thread(&BuildWorkers::work, this).detach();
+                        }catch(...){
+                            // Leave the task to a running worker, if any.
+                            if(my_running == 0){
+                                my_tasks.pop_back();
+                                throw;
+                            }
+                            return;
+                        }
+                        ++my_running;
+                    }
+                }
+
+            private:
+                BuildWorkers()
+                    : my_max_threads(std::max(std::thread::hardware_concurrency(), 1u)), my_running(0)
+                {}
+
+                void work()
+                {
+                    std::unique_lock<std::mutex> lock(my_mutex);
+                    while(!my_tasks.empty()){
+                        std::function<void()> task;
+                        task.swap(my_tasks.front());
+                        my_tasks.pop_front();
+                        lock.unlock();
+                        task();
+                        lock.lock();
+                    }
+                    --my_running;
+                }
+
+                size_t my_max_threads;
+                std::mutex my_mutex;
+                std::deque< std::function<void()> > my_tasks;
+                size_t my_running;
+        };
+
+        static Program createProgram(cl_context context, const char* source)
+        {
+            cl_int err;
+            cl_program pid = clCreateProgramWithSource(context, 1, const_cast<const char**>(&source), NULL, &err);
+            CLPP_CHECK_ERROR(err);
+            return Program(pid);
+        }
+
+        static Program buildSource(cl_context context, const DeviceList& devices, ProgramCache* cache, const char* source, const char* options)
+        {
+            if(cache)
+                return cache->build(context, devices, source, options);
+
+            Program p = createProgram(context, source);
+            p.build(devices, options);
+            return p;
+        }
+
         void initQueues()
         {
             cl_int err;
             for(size_t i = 0; i < my_devices.size(); ++i){
                 cl_command_queue q = clCreateCommandQueue(id(), my_devices[i].id(), 0, &err);
                 CLPP_CHECK_ERROR(err);
-                my_queues.push_back(CommandQueue(q));
+                my_queues.push_back(CommandQueue(q, my_devices[i]));
             }
         }
 
         Resource<cl_context> my_resource;
         DeviceList my_devices;
         std::vector<CommandQueue> my_queues;
+        std::shared_ptr<BufferPool> my_pool;
+        std::shared_ptr<ProgramCache> my_program_cache;
 };
 
 } // namespace clpp
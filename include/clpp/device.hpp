@@ -6,29 +6,179 @@
 #ifndef CLPP_DEVICE_HPP
 #define CLPP_DEVICE_HPP
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "error.hpp"
+#include "resource.hpp"
 #include "vector.hpp"
+#include "deviceinfo.hpp"
 
 namespace clpp {
 
+class DeviceList;
+
+#ifdef CL_VERSION_1_2
+/// A way to partition a device into sub-devices.
+/** Sub-devices are created by Device::partition. For example, a CPU device
+    spanning two sockets can be split into one sub-device per NUMA node:
+
+    \code
+    DeviceList nodes = cpu.partition(Partition::byAffinityDomain(CL_DEVICE_AFFINITY_DOMAIN_NUMA));
+    \endcode
+
+    The partition types supported by a device are given by
+    \c CL_DEVICE_PARTITION_PROPERTIES and \c CL_DEVICE_PARTITION_AFFINITY_DOMAIN.
+ */
+class Partition {
+    public:
+        /// Partition a device into as many sub-devices as possible, each
+        /// with the same number of compute units.
+        /**
+            \param units    The number of compute units in each sub-device.
+         */
+        static Partition equally(cl_uint units)
+        {
+            Partition p;
+            p.my_properties.push_back(CL_DEVICE_PARTITION_EQUALLY);
+            p.my_properties.push_back(static_cast<cl_device_partition_property>(units));
+            p.my_properties.push_back(0);
+            return p;
+        }
+
+        /// Partition a device into sub-devices with given numbers of compute
+        /// units.
+        /**
+            \param counts   The number of compute units in each sub-device.
+         */
+        static Partition byCounts(const std::vector<cl_uint>& counts)
+        {
+            Partition p;
+            p.my_properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS);
+            for(size_t i = 0; i < counts.size(); ++i)
+                p.my_properties.push_back(static_cast<cl_device_partition_property>(counts[i]));
+            p.my_properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS_LIST_END);
+            p.my_properties.push_back(0);
+            return p;
+        }
+
+        /// Partition a device into sub-devices which share a level of the
+        /// memory hierarchy.
+        /**
+            \param domain   \c CL_DEVICE_AFFINITY_DOMAIN_NUMA for one sub-device
+                            per NUMA node, \c CL_DEVICE_AFFINITY_DOMAIN_L3_CACHE
+                            for one per L3 cache, etc. By default, the
+                            device is split along the first level it can be
+                            partitioned by.
+         */
+        static Partition byAffinityDomain(cl_device_affinity_domain domain = CL_DEVICE_AFFINITY_DOMAIN_NEXT_PARTITIONABLE)
+        {
+            Partition p;
+            p.my_properties.push_back(CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN);
+            p.my_properties.push_back(static_cast<cl_device_partition_property>(domain));
+            p.my_properties.push_back(0);
+            return p;
+        }
+
+        /// Get the property list passed to \c clCreateSubDevices.
+        const cl_device_partition_property* properties() const
+        {
+            return &my_properties[0];
+        }
+
+    private:
+        Partition() {}
+
+        std::vector<cl_device_partition_property> my_properties;
+}; // class Partition
+#endif
+
 /// The OpenCL device.
 /** A device is a collection of compute units. A command-queue is used to
     queue commands to a device. Examples of commands include executing kernels,
     or reading and writing memory objects. OpenCL devices typically correspond
     to a GPU, a multi-core CPU, and other processors such as DSPs and the
     Cell/B.E. processor.
+
+    Properties of a device never change, so they are queried together into
+    a DeviceInfo the first time one of them is requested, and cached. Copies
+    of a Device share the cache once it is filled.
+
+    A sub-device created by partition() is retained by the Device object and
+    all its copies, and released when the last of them is destroyed. Root
+    devices are not reference counted.
  */
 class Device {
     public:
         /// Construct the Device object by the specified device ID.
         Device(cl_device_id id) : my_id(id) {}
 
+        Device(const Device& d) : my_id(d.my_id), my_info(std::atomic_load(&d.my_info))
+#ifdef CL_VERSION_1_2
+            , my_owner(d.my_owner)
+#endif
+        {}
+
+        Device& operator=(const Device& d)
+        {
+            my_id = d.my_id;
+            std::atomic_store(&my_info, std::atomic_load(&d.my_info));
+#ifdef CL_VERSION_1_2
+            my_owner = d.my_owner;
+#endif
+            return *this;
+        }
+
         /// Get the device ID.
         cl_device_id id() const
         {
             return my_id;
         }
 
+#ifdef CL_VERSION_1_2
+        /// Partition the device into sub-devices.
+        /** Each sub-device can be used like a device, e.g. to create a
+            Context with a command queue per sub-device, so that work can be
+            pinned to a socket or a cache domain.
+
+            \param p    The way to partition the device.
+            \return     The sub-devices. Each of them is released when the
+                        last Device object referring to it is destroyed.
+                        The list is empty if the device is not partitioned.
+         */
+        DeviceList partition(const Partition& p) const;
+
+        /// Get the device this sub-device was partitioned from.
+        /**
+            \return     The parent device, or a device with a null ID if
+                        this is not a sub-device.
+         */
+        Device parent() const
+        {
+            return Device(getInfo<cl_device_id>(CL_DEVICE_PARENT_DEVICE));
+        }
+
+        /// Get the maximum number of sub-devices the device can be
+        /// partitioned into.
+        cl_uint getPartitionMaxSubDevices() const
+        {
+            return getInfo<cl_uint>(CL_DEVICE_PARTITION_MAX_SUB_DEVICES);
+        }
+#endif
+
+        /// Get the snapshot of all properties of the device.
+        /** The properties are queried only once for this object and its
+            copies, so the snapshot can be read repeatedly, e.g. by a
+            scheduler, without calling OpenCL.
+
+            \return     The snapshot.
+         */
+        DeviceInfo info() const
+        {
+            return *cachedInfo();
+        }
+
         /// Get the device name.
         std::string name() const;
 
@@ -38,6 +188,9 @@ class Device {
         /// Get the version string of the device.
         std::string version() const;
 
+        /// Get the version string of the driver.
+        std::string driverVersion() const;
+
         /// Get the profile string of the device.
         std::string profile() const;
 
@@ -47,7 +200,7 @@ class Device {
         /// Get the device type.
         cl_device_type type() const
         {
-            return getInfo<cl_device_type>(CL_DEVICE_TYPE);
+            return cachedInfo()->type;
         }
 
         /// Check if the device is available.
@@ -66,7 +219,7 @@ class Device {
          */
         bool hasCompiler() const
         {
-            return getInfo<cl_bool>(CL_DEVICE_COMPILER_AVAILABLE) == CL_TRUE;
+            return cachedInfo()->compiler;
         }
 
         /// Check if the device support error correction.
@@ -76,7 +229,7 @@ class Device {
          */
         bool hasErrorCorrection() const
         {
-            return getInfo<cl_bool>(CL_DEVICE_ERROR_CORRECTION_SUPPORT) == CL_TRUE;
+            return cachedInfo()->error_correction;
         }
 
         /// Check if the device supports images
@@ -86,7 +239,7 @@ class Device {
          */
         bool hasImageSupport() const
         {
-            return getInfo<cl_bool>(CL_DEVICE_IMAGE_SUPPORT) == CL_TRUE;
+            return cachedInfo()->image_support;
         }
 
         /// Check if the device are capable to execute native kernels.
@@ -94,9 +247,9 @@ class Device {
             \return     \a true if the device is capable to execute native
                         kernels, and \a false if not.
          */
-        bool hasNativeKernelSupport()
+        bool hasNativeKernelSupport() const
         {
-            return (getInfo<cl_device_exec_capabilities>(CL_DEVICE_EXECUTION_CAPABILITIES) & CL_EXEC_NATIVE_KERNEL) != 0;
+            return (cachedInfo()->execution_capabilities & CL_EXEC_NATIVE_KERNEL) != 0;
         }
 
         /// Get the maximum size of a 2D image supported by the device.
@@ -106,8 +259,7 @@ class Device {
          */
         size2 getImage2DMaxSize() const
         {
-            return size2( getInfo<size_t>(CL_DEVICE_IMAGE2D_MAX_WIDTH),
-                          getInfo<size_t>(CL_DEVICE_IMAGE2D_MAX_HEIGHT) );
+            return cachedInfo()->image2d_max_size;
         }
 
         /// Get the maximum size of a 3D image supported by the device.
@@ -117,9 +269,7 @@ class Device {
          */
         size3 getImage3DMaxSize() const
         {
-            return size3( getInfo<size_t>(CL_DEVICE_IMAGE3D_MAX_WIDTH),
-                          getInfo<size_t>(CL_DEVICE_IMAGE3D_MAX_HEIGHT),
-                          getInfo<size_t>(CL_DEVICE_IMAGE3D_MAX_DEPTH) );
+            return cachedInfo()->image3d_max_size;
         }
 
         /// Get the maximum clock frequency in MHz of this device.
@@ -128,7 +278,7 @@ class Device {
          */
         cl_uint getMaxClockFrequency() const
         {
-            return getInfo<cl_uint>(CL_DEVICE_MAX_CLOCK_FREQUENCY);
+            return cachedInfo()->max_clock_frequency;
         }
 
         /// The number of parallel compute cores on the device.
@@ -137,7 +287,7 @@ class Device {
          */
         cl_uint getMaxComputeUnits() const
         {
-            return getInfo<cl_uint>(CL_DEVICE_MAX_COMPUTE_UNITS);
+            return cachedInfo()->max_compute_units;
         }
 
         /// Get the size in bytes of global device memory.
@@ -146,7 +296,7 @@ class Device {
          */
         cl_ulong getGlobalMemSize() const
         {
-            return getInfo<cl_ulong>(CL_DEVICE_GLOBAL_MEM_SIZE);
+            return cachedInfo()->global_mem_size;
         }
 
         /// Get the size in bytes of local device memory.
@@ -155,7 +305,7 @@ class Device {
          */
         cl_ulong getLocalMemSize() const
         {
-            return getInfo<cl_ulong>(CL_DEVICE_LOCAL_MEM_SIZE);
+            return cachedInfo()->local_mem_size;
         }
 
         /// Get the maximum size in bytes of memory object allocation.
@@ -164,7 +314,7 @@ class Device {
          */
         cl_ulong getMaxMemAllocSize() const
         {
-            return getInfo<cl_ulong>(CL_DEVICE_MAX_MEM_ALLOC_SIZE);
+            return cachedInfo()->max_mem_alloc_size;
         }
 
         /// Get the maximum size of arguments.
@@ -174,7 +324,7 @@ class Device {
          */
         size_t getMaxParameterSize() const
         {
-            return getInfo<size_t>(CL_DEVICE_MAX_PARAMETER_SIZE);
+            return cachedInfo()->max_parameter_size;
         }
 
         /// Get the maximum number of work-items in a work-group.
@@ -183,7 +333,7 @@ class Device {
          */
         size_t getMaxWorkGroupSize() const
         {
-            return getInfo<size_t>(CL_DEVICE_MAX_WORK_GROUP_SIZE);
+            return cachedInfo()->max_work_group_size;
         }
 
         /// Get the maximum number of work-items supported by this device.
@@ -195,12 +345,19 @@ class Device {
                         The maximum number of work-items is the product of
                         each element in this vector.
          */
-        std::vector<size_t> getMaxWorkItemSizes()
+        std::vector<size_t> getMaxWorkItemSizes() const
+        {
+            return cachedInfo()->max_work_item_sizes;
+        }
+
+        /// Get the alignment of the base address of sub-buffers.
+        /**
+            \return     The minimum alignment in bits of the base address of
+                        any memory object allocated for this device.
+         */
+        cl_uint getMemBaseAddrAlign() const
         {
-            size_t dim = getInfo<cl_uint>(CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS);
-            std::vector<size_t> msize(dim);
-            clGetDeviceInfo(id(), CL_DEVICE_MAX_WORK_ITEM_SIZES, sizeof(size_t)*dim, &msize[0], NULL);
-            return msize;
+            return cachedInfo()->mem_base_addr_align;
         }
 
         /// Get device information about the device.
@@ -219,7 +376,62 @@ class Device {
         }
 
     private:
+        // The cache may be filled by several threads at the same time. They
+        // all store equal values, so it doesn't matter which one wins.
+        std::shared_ptr<const DeviceInfo> cachedInfo() const
+        {
+            std::shared_ptr<const DeviceInfo> cached = std::atomic_load(&my_info);
+            if(cached)
+                return cached;
+
+            std::shared_ptr<DeviceInfo> info(new DeviceInfo);
+#define CLPP_DEVICE_INFO_QUERY(type, field, query) queryInfo(query, info->field);
+            CLPP_DEVICE_INFO_FIELDS(CLPP_DEVICE_INFO_QUERY)
+#undef CLPP_DEVICE_INFO_QUERY
+
+            cached = info;
+            std::atomic_store(&my_info, cached);
+            return cached;
+        }
+
+        template <typename T> void queryInfo(cl_device_info info, T& value) const
+        {
+            value = getInfo<T>(info);
+        }
+
+        void queryInfo(cl_device_info info, bool& value) const
+        {
+            value = getInfo<cl_bool>(info) == CL_TRUE;
+        }
+
+        void queryInfo(cl_device_info info, std::string& value) const;
+
+        void queryInfo(cl_device_info, size2& value) const
+        {
+            value = size2( getInfo<size_t>(CL_DEVICE_IMAGE2D_MAX_WIDTH),
+                           getInfo<size_t>(CL_DEVICE_IMAGE2D_MAX_HEIGHT) );
+        }
+
+        void queryInfo(cl_device_info, size3& value) const
+        {
+            value = size3( getInfo<size_t>(CL_DEVICE_IMAGE3D_MAX_WIDTH),
+                           getInfo<size_t>(CL_DEVICE_IMAGE3D_MAX_HEIGHT),
+                           getInfo<size_t>(CL_DEVICE_IMAGE3D_MAX_DEPTH) );
+        }
+
+        void queryInfo(cl_device_info info, std::vector<size_t>& value) const
+        {
+            value.resize(getInfo<cl_uint>(CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS));
+            cl_int err = clGetDeviceInfo(my_id, info, sizeof(size_t)*value.size(), &value[0], NULL);
+            CLPP_CHECK_ERROR(err);
+        }
+
         cl_device_id my_id;
+        mutable std::shared_ptr<const DeviceInfo> my_info;
+#ifdef CL_VERSION_1_2
+        // The reference to a sub-device, or null for a root device.
+        std::shared_ptr< Resource<cl_device_id> > my_owner;
+#endif
 }; // class Device
 
 // GCC gives an error if we put this explicit specialization inside the class definition.
@@ -237,29 +449,40 @@ template <> inline std::string Device::getInfo<std::string>(cl_device_info info)
     return buf;
 }
 
+// Strings are stored without the terminating null character.
+inline void Device::queryInfo(cl_device_info info, std::string& value) const
+{
+    value = getInfo<std::string>(info).c_str();
+}
+
 inline std::string Device::name() const
 {
-    return getInfo<std::string>(CL_DEVICE_NAME);
+    return cachedInfo()->name;
 }
 
 inline std::string Device::vendor() const
 {
-    return getInfo<std::string>(CL_DEVICE_VENDOR);
+    return cachedInfo()->vendor;
 }
 
 inline std::string Device::version() const
 {
-    return getInfo<std::string>(CL_DEVICE_VERSION);
+    return cachedInfo()->version;
+}
+
+inline std::string Device::driverVersion() const
+{
+    return cachedInfo()->driver_version;
 }
 
 inline std::string Device::profile() const
 {
-    return getInfo<std::string>(CL_DEVICE_PROFILE);
+    return cachedInfo()->profile;
 }
 
 inline std::string Device::extensions() const
 {
-    return getInfo<std::string>(CL_DEVICE_EXTENSIONS);
+    return cachedInfo()->extensions;
 }
 
 
@@ -0,0 +1,218 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_DEVICEINFO_HPP
+#define CLPP_DEVICEINFO_HPP
+
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "size.hpp"
+
+// X(type, field, query) for every field of DeviceInfo, in serialization order.
+#define CLPP_DEVICE_INFO_FIELDS(X) \
+    X(std::string,                  name,                           CL_DEVICE_NAME) \
+    X(std::string,                  vendor,                         CL_DEVICE_VENDOR) \
+    X(std::string,                  version,                        CL_DEVICE_VERSION) \
+    X(std::string,                  driver_version,                 CL_DRIVER_VERSION) \
+    X(std::string,                  profile,                        CL_DEVICE_PROFILE) \
+    X(std::string,                  extensions,                     CL_DEVICE_EXTENSIONS) \
+    X(cl_device_type,               type,                           CL_DEVICE_TYPE) \
+    X(cl_uint,                      vendor_id,                      CL_DEVICE_VENDOR_ID) \
+    X(bool,                         available,                      CL_DEVICE_AVAILABLE) \
+    X(bool,                         compiler,                       CL_DEVICE_COMPILER_AVAILABLE) \
+    X(bool,                         endian_little,                  CL_DEVICE_ENDIAN_LITTLE) \
+    X(bool,                         error_correction,               CL_DEVICE_ERROR_CORRECTION_SUPPORT) \
+    X(cl_device_exec_capabilities,  execution_capabilities,         CL_DEVICE_EXECUTION_CAPABILITIES) \
+    X(cl_command_queue_properties,  queue_properties,               CL_DEVICE_QUEUE_PROPERTIES) \
+    X(cl_uint,                      max_compute_units,              CL_DEVICE_MAX_COMPUTE_UNITS) \
+    X(cl_uint,                      max_clock_frequency,            CL_DEVICE_MAX_CLOCK_FREQUENCY) \
+    X(cl_uint,                      address_bits,                   CL_DEVICE_ADDRESS_BITS) \
+    X(size_t,                       max_work_group_size,            CL_DEVICE_MAX_WORK_GROUP_SIZE) \
+    X(std::vector<size_t>,          max_work_item_sizes,            CL_DEVICE_MAX_WORK_ITEM_SIZES) \
+    X(cl_uint,                      preferred_vector_width_char,    CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR) \
+    X(cl_uint,                      preferred_vector_width_short,   CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT) \
+    X(cl_uint,                      preferred_vector_width_int,     CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT) \
+    X(cl_uint,                      preferred_vector_width_long,    CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG) \
+    X(cl_uint,                      preferred_vector_width_float,   CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT) \
+    X(cl_uint,                      preferred_vector_width_double,  CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE) \
+    X(cl_device_fp_config,          single_fp_config,               CL_DEVICE_SINGLE_FP_CONFIG) \
+    X(cl_ulong,                     global_mem_size,                CL_DEVICE_GLOBAL_MEM_SIZE) \
+    X(cl_device_mem_cache_type,     global_mem_cache_type,          CL_DEVICE_GLOBAL_MEM_CACHE_TYPE) \
+    X(cl_ulong,                     global_mem_cache_size,          CL_DEVICE_GLOBAL_MEM_CACHE_SIZE) \
+    X(cl_uint,                      global_mem_cacheline_size,      CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE) \
+    X(cl_device_local_mem_type,     local_mem_type,                 CL_DEVICE_LOCAL_MEM_TYPE) \
+    X(cl_ulong,                     local_mem_size,                 CL_DEVICE_LOCAL_MEM_SIZE) \
+    X(cl_ulong,                     max_constant_buffer_size,       CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE) \
+    X(cl_uint,                      max_constant_args,              CL_DEVICE_MAX_CONSTANT_ARGS) \
+    X(cl_ulong,                     max_mem_alloc_size,             CL_DEVICE_MAX_MEM_ALLOC_SIZE) \
+    X(size_t,                       max_parameter_size,             CL_DEVICE_MAX_PARAMETER_SIZE) \
+    X(cl_uint,                      mem_base_addr_align,            CL_DEVICE_MEM_BASE_ADDR_ALIGN) \
+    X(cl_uint,                      min_data_type_align_size,       CL_DEVICE_MIN_DATA_TYPE_ALIGN_SIZE) \
+    X(bool,                         image_support,                  CL_DEVICE_IMAGE_SUPPORT) \
+    X(size2,                        image2d_max_size,               CL_DEVICE_IMAGE2D_MAX_WIDTH) \
+    X(size3,                        image3d_max_size,               CL_DEVICE_IMAGE3D_MAX_WIDTH) \
+    X(cl_uint,                      max_read_image_args,            CL_DEVICE_MAX_READ_IMAGE_ARGS) \
+    X(cl_uint,                      max_write_image_args,           CL_DEVICE_MAX_WRITE_IMAGE_ARGS) \
+    X(cl_uint,                      max_samplers,                   CL_DEVICE_MAX_SAMPLERS) \
+    X(size_t,                       profiling_timer_resolution,     CL_DEVICE_PROFILING_TIMER_RESOLUTION)
+
+namespace clpp {
+
+/// A snapshot of the properties of a device.
+/** A DeviceInfo holds the result of every \c clGetDeviceInfo query which is
+    relevant to scheduling and kernel tuning, so that they can be read
+    without calling OpenCL. Please use Device::info to get the snapshot of a
+    device.
+
+    Each field is named after its \c CL_DEVICE_* query in lower case, e.g.
+    \a global_mem_cacheline_size holds \c CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE.
+    Strings don't contain the terminating null character. The two image
+    sizes combine the width, height and depth queries.
+
+    Snapshots can be compared, and written to and read from streams, e.g.
+    to detect that the devices of a machine have changed since a scheduler
+    profile was saved. The stream format has one line per field, containing
+    the field name and the value separated by a tab.
+ */
+struct DeviceInfo {
+#define CLPP_DEVICE_INFO_DECLARE(type, field, query) type field;
+    CLPP_DEVICE_INFO_FIELDS(CLPP_DEVICE_INFO_DECLARE)
+#undef CLPP_DEVICE_INFO_DECLARE
+
+    /// Construct a snapshot with all fields zero or empty.
+    DeviceInfo()
+    {
+#define CLPP_DEVICE_INFO_INIT(type, field, query) field = type();
+        CLPP_DEVICE_INFO_FIELDS(CLPP_DEVICE_INFO_INIT)
+#undef CLPP_DEVICE_INFO_INIT
+    }
+
+    /// Check if two snapshots are equal in all fields.
+    friend bool operator==(const DeviceInfo& a, const DeviceInfo& b)
+    {
+#define CLPP_DEVICE_INFO_EQUAL(type, field, query) if(!equal(a.field, b.field)) return false;
+        CLPP_DEVICE_INFO_FIELDS(CLPP_DEVICE_INFO_EQUAL)
+#undef CLPP_DEVICE_INFO_EQUAL
+        return true;
+    }
+
+    /// Check if two snapshots differ in any field.
+    friend bool operator!=(const DeviceInfo& a, const DeviceInfo& b)
+    {
+        return !(a == b);
+    }
+
+    /// Write a snapshot to a stream.
+    friend std::ostream& operator<<(std::ostream& s, const DeviceInfo& info)
+    {
+#define CLPP_DEVICE_INFO_WRITE(type, field, query) s << #field << '\t'; write(s, info.field); s << '\n';
+        CLPP_DEVICE_INFO_FIELDS(CLPP_DEVICE_INFO_WRITE)
+#undef CLPP_DEVICE_INFO_WRITE
+        return s;
+    }
+
+    /// Read a snapshot written by operator<<.
+    /** The fail bit of the stream is set if the fields don't match.
+     */
+    friend std::istream& operator>>(std::istream& s, DeviceInfo& info)
+    {
+        DeviceInfo tmp;
+        std::string line;
+#define CLPP_DEVICE_INFO_READ(type, field, query) \
+        if(!std::getline(s, line) || line.compare(0, sizeof(#field), #field "\t") != 0 \
+           || !read(line.substr(sizeof(#field)), tmp.field)){ \
+            s.setstate(std::ios::failbit); \
+            return s; \
+        }
+        CLPP_DEVICE_INFO_FIELDS(CLPP_DEVICE_INFO_READ)
+#undef CLPP_DEVICE_INFO_READ
+        info = tmp;
+        return s;
+    }
+
+    private:
+        template <typename T> static bool equal(const T& a, const T& b)
+        {
+            return a == b;
+        }
+
+        static bool equal(const size2& a, const size2& b)
+        {
+            return a.s[0] == b.s[0] && a.s[1] == b.s[1];
+        }
+
+        static bool equal(const size3& a, const size3& b)
+        {
+            return a.s[0] == b.s[0] && a.s[1] == b.s[1] && a.s[2] == b.s[2];
+        }
+
+        template <typename T> static void write(std::ostream& s, const T& v)
+        {
+            s << v;
+        }
+
+        static void write(std::ostream& s, const size2& v)
+        {
+            s << v.s[0] << ' ' << v.s[1];
+        }
+
+        static void write(std::ostream& s, const size3& v)
+        {
+            s << v.s[0] << ' ' << v.s[1] << ' ' << v.s[2];
+        }
+
+        static void write(std::ostream& s, const std::vector<size_t>& v)
+        {
+            s << v.size();
+            for(size_t i = 0; i < v.size(); ++i)
+                s << ' ' << v[i];
+        }
+
+        template <typename T> static bool read(const std::string& text, T& v)
+        {
+            std::istringstream s(text);
+            return static_cast<bool>(s >> v);
+        }
+
+        static bool read(const std::string& text, std::string& v)
+        {
+            v = text;
+            return true;
+        }
+
+        static bool read(const std::string& text, size2& v)
+        {
+            std::istringstream s(text);
+            return static_cast<bool>(s >> v.s[0] >> v.s[1]);
+        }
+
+        static bool read(const std::string& text, size3& v)
+        {
+            std::istringstream s(text);
+            return static_cast<bool>(s >> v.s[0] >> v.s[1] >> v.s[2]);
+        }
+
+        static bool read(const std::string& text, std::vector<size_t>& v)
+        {
+            std::istringstream s(text);
+            size_t n = 0;
+            if(!(s >> n))
+                return false;
+            v.resize(n);
+            for(size_t i = 0; i < n; ++i)
+                if(!(s >> v[i]))
+                    return false;
+            return true;
+        }
+}; // struct DeviceInfo
+
+} // namespace clpp
+
+#endif // CLPP_DEVICEINFO_HPP
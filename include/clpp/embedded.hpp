@@ -0,0 +1,167 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_EMBEDDED_HPP
+#define CLPP_EMBEDDED_HPP
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "error.hpp"
+
+namespace clpp {
+
+/// A program source embedded in the executable.
+/** Embedded sources are generated from \c .cl files by
+    \c tools/embedcl.lua at build time, so the program sources always match
+    the executable and don't have to be read from the file system.
+
+    The hash is computed by the generator with Fnv1a64, so the program cache
+    can use it without hashing the source again.
+
+    \sa EmbeddedSources, Context::readProgramSource(const EmbeddedSource&, const char*)
+ */
+struct EmbeddedSource {
+    /// The file name of the source, without directories.
+    const char* name;
+
+    /// The null-terminated source code.
+    const char* source;
+
+    /// The length of the source code in bytes.
+    size_t size;
+
+    /// The Fnv1a64 hash of the source code.
+    cl_ulong hash;
+};
+
+/// The registry of embedded program sources.
+/** Headers generated by \c tools/embedcl.lua register their sources when
+    the program starts, e.g. for a header generated by
+
+    \code
+    lua tools/embedcl.lua -n kernels saxpy.cl reduce.cl > kernels.hpp
+    \endcode
+
+    the sources are fetched by their file names:
+
+    \code
+    #include "kernels.hpp"
+
+    Program p = context.readProgramSource(EmbeddedSources::get("saxpy.cl"));
+    \endcode
+
+    All member functions are thread-safe.
+ */
+class EmbeddedSources {
+    public:
+        /// The exception object for names which aren't registered.
+        class NotFound : public Error {
+            public:
+                NotFound(const char* filename,
+                         const char* func,
+                         size_t line,
+                         const std::string& name)
+                    : Error(CL_INVALID_VALUE, filename, func, line),
+                      my_message("No embedded program source named " + name)
+                {}
+
+                /// Get the description of the error.
+                virtual const char* what() const throw()
+                {
+                    return my_message.c_str();
+                }
+
+                virtual ~NotFound() throw()
+                {}
+
+            private:
+                std::string my_message;
+        };
+
+        /// Register embedded sources.
+        /** The sources must stay valid until the program exits, which is
+            the case for the tables in generated headers. A name which is
+            already registered keeps its first source, so a generated header
+            can be included in several translation units.
+
+            \param sources  The table of sources.
+            \param count    The number of sources in \a sources.
+         */
+        static void add(const EmbeddedSource* sources, size_t count)
+        {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for(size_t i = 0; i < count; ++i)
+                r.sources.insert(std::make_pair(std::string(sources[i].name), &sources[i]));
+        }
+
+        /// Find an embedded source.
+        /**
+            \param name     The file name of the source.
+            \return         The source, or NULL if \a name isn't registered.
+         */
+        static const EmbeddedSource* find(const std::string& name)
+        {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            std::map<std::string, const EmbeddedSource*>::const_iterator i = r.sources.find(name);
+            return i != r.sources.end() ? i->second : NULL;
+        }
+
+        /// Get an embedded source.
+        /**
+            \param name     The file name of the source.
+            \return         The source.
+            \throw NotFound If \a name isn't registered.
+         */
+        static const EmbeddedSource& get(const std::string& name)
+        {
+            const EmbeddedSource* s = find(name);
+            if(!s)
+                throw NotFound(__FILE__, __FUNCTION__, __LINE__, name);
+            return *s;
+        }
+
+        /// Get the names of all embedded sources, in sorted order.
+        static std::vector<std::string> names()
+        {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            std::vector<std::string> result;
+            for(std::map<std::string, const EmbeddedSource*>::const_iterator i = r.sources.begin(); i != r.sources.end(); ++i)
+                result.push_back(i->first);
+            return result;
+        }
+
+    private:
+        struct Registry {
+            std::mutex mutex;
+            std::map<std::string, const EmbeddedSource*> sources;
+        };
+
+        static Registry& registry()
+        {
+            static Registry r;
+            return r;
+        }
+}; // class EmbeddedSources
+
+/// Registers a table of embedded sources at static initialization.
+/** It is used by headers generated by \c tools/embedcl.lua.
+ */
+struct EmbeddedSourceRegistrar {
+    EmbeddedSourceRegistrar(const EmbeddedSource* sources, size_t count)
+    {
+        EmbeddedSources::add(sources, count);
+    }
+};
+
+} // namespace clpp
+
+#endif // CLPP_EMBEDDED_HPP
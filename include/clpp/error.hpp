@@ -79,6 +79,7 @@ inline const char* GetErrorCodeName(cl_int code)
         CLPP_CODE_NAME(CL_INVALID_SAMPLER)
         CLPP_CODE_NAME(CL_INVALID_VALUE)
         CLPP_CODE_NAME(CL_INVALID_WORK_DIMENSION)
+        CLPP_CODE_NAME(CL_INVALID_WORK_GROUP_SIZE)
         CLPP_CODE_NAME(CL_INVALID_WORK_ITEM_SIZE)
 
         CLPP_CODE_NAME(CL_COMPILER_NOT_AVAILABLE)
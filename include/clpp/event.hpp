@@ -6,6 +6,13 @@
 #ifndef CLPP_EVENT_HPP
 #define CLPP_EVENT_HPP
 
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include <utility>
+
 #include "resource.hpp"
 #include "error.hpp"
 
@@ -142,11 +149,62 @@ class Event {
         }
 
         /// Wait until the command identified by this event object has finished execution.
+        /** Waiting for a null event returns immediately.
+         */
         void wait()
         {
             cl_event e = id();
-            clWaitForEvents(1, &e);
+            if(e != 0)
+                clWaitForEvents(1, &e);
+        }
+
+#ifdef CL_VERSION_1_1
+        /// Call a function when the command identified by this event object has finished.
+        /** The function is called by \c clSetEventCallback, on a thread of
+            the OpenCL implementation, so it must be short and must not call
+            blocking functions such as wait() or blocking copies. Exceptions
+            thrown by the function are ignored. For a null event, the function
+            is called immediately on the calling thread.
+
+            \param callback    The function, called with \c CL_COMPLETE, or
+                                a negative error code if the command was
+                                terminated abnormally.
+         */
+        void then(const std::function<void(cl_int)>& callback) const
+        {
+            if(id() == 0){
+                notify(callback, CL_COMPLETE);
+                return;
+            }
+
+            // The pending callback keeps the event retained until it is
+            // called.
+            std::unique_ptr<Pending> p(new Pending(my_resource, callback));
+            cl_int err = clSetEventCallback(id(), CL_COMPLETE, &onComplete, p.get());
+            CLPP_CHECK_ERROR(err);
+            p.release();
+        }
+
+        /// Get a future which becomes ready when the command identified by this event object has finished.
+        /** Unlike wait(), no thread is blocked until the future is waited
+            on, so many commands can be in flight with a few threads.
+
+            \return     The future. It holds an Error if the command was
+                        terminated abnormally.
+         */
+        std::future<void> toFuture() const
+        {
+            std::shared_ptr<std::promise<void> > promise(new std::promise<void>);
+            std::future<void> result = promise->get_future();
+            then([promise](cl_int status){
+                if(status < 0)
+                    promise->set_exception(std::make_exception_ptr(Error(status, __FILE__, __FUNCTION__, __LINE__)));
+                else
+                    promise->set_value();
+            });
+            return result;
         }
+#endif
 
         /// Swap the pointed content with another event object.
         /**
@@ -158,9 +216,180 @@ class Event {
         }
 
     private:
+#ifdef CL_VERSION_1_1
+        struct Pending {
+            Pending(const Resource<cl_event>& e, const std::function<void(cl_int)>& f) : event(e), callback(f) {}
+
+            Resource<cl_event> event;
+            std::function<void(cl_int)> callback;
+        };
+
+        static void notify(const std::function<void(cl_int)>& callback, cl_int status)
+        {
+            try{
+                callback(status);
+            }catch(...){
+                // Exceptions must not propagate into the OpenCL implementation.
+            }
+        }
+
+        static void CL_CALLBACK onComplete(cl_event, cl_int status, void* user_data)
+        {
+            Pending* p = static_cast<Pending*>(user_data);
+            notify(p->callback, status);
+            delete p;
+        }
+#endif
+
         Resource<cl_event> my_resource;
 }; // class Event
 
+/// A list of events.
+/** An event list is passed to the enqueue functions of CommandQueue as the
+    wait list of a command. The command doesn't start before all events in
+    the list are complete. Events may come from other command queues in the
+    same context, so fine-grained dependencies can be expressed across
+    several queues without a barrier.
+
+    The list retains every event added to it.
+ */
+class EventList {
+    public:
+        /// Construct an empty event list.
+        EventList() {}
+
+        /// Construct an event list containing exactly one event.
+        /** A null event is ignored.
+
+            \param e    The event contained in this list.
+         */
+        EventList(const Event& e)
+        {
+            append(e);
+        }
+
+        EventList(const EventList& list) : my_events(list.my_events)
+        {
+            for(size_t i = 0; i < my_events.size(); ++i)
+                CLPP_CHECK_ERROR(clRetainEvent(my_events[i]));
+        }
+
+        EventList(EventList&& list) throw() : my_events(std::move(list.my_events))
+        {
+            list.my_events.clear();
+        }
+
+        EventList& operator=(const EventList& list)
+        {
+            EventList tmp(list);
+            swap(tmp);
+            return *this;
+        }
+
+        EventList& operator=(EventList&& list) throw()
+        {
+            EventList tmp(std::move(list));
+            swap(tmp);
+            return *this;
+        }
+
+        ~EventList() throw()
+        {
+            for(size_t i = 0; i < my_events.size(); ++i)
+                clReleaseEvent(my_events[i]);
+        }
+
+        /// Append an event to this list.
+        /** A null event, e.g. the result of a command enqueued without an
+            event, is ignored.
+
+            \param e    The event to be appended.
+         */
+        void append(const Event& e)
+        {
+            cl_event id = e.id();
+            if(id == 0)
+                return;
+            my_events.push_back(id);
+            cl_int err = clRetainEvent(id);
+            if(err != CL_SUCCESS){
+                my_events.pop_back();
+                CLPP_CHECK_ERROR(err);
+            }
+        }
+
+        /// Append all events in another list to this list.
+        /**
+            \param list The list of events to be appended.
+         */
+        void append(const EventList& list)
+        {
+            for(size_t i = 0; i < list.size(); ++i)
+                append(list[i]);
+        }
+
+        /// Remove all events from this list.
+        void clear() throw()
+        {
+            EventList tmp;
+            swap(tmp);
+        }
+
+        /// Get the number of events in this list.
+        cl_uint size() const
+        {
+            return static_cast<cl_uint>(my_events.size());
+        }
+
+        /// Check if this list is empty.
+        bool empty() const
+        {
+            return my_events.empty();
+        }
+
+        /// Get the specific event in this list.
+        /**
+            \param i    The number of the specified event.
+            \return     The \a i 'th event in this list.
+         */
+        Event operator[](size_t i) const
+        {
+            cl_event id = my_events[i];
+            CLPP_CHECK_ERROR(clRetainEvent(id));
+            return Event(id);
+        }
+
+        /// Get the raw pointer to cl_event in this list.
+        /**
+            \return     The pointer to the list of <tt>cl_event</tt>s, which
+                        can be used as an event wait list in OpenCL API. It
+                        is \c NULL if the list is empty.
+         */
+        const cl_event* data() const
+        {
+            return my_events.empty() ? NULL : &my_events[0];
+        }
+
+        /// Wait until all events in this list are complete.
+        void wait() const
+        {
+            if(!my_events.empty())
+                CLPP_CHECK_ERROR( clWaitForEvents(size(), data()) );
+        }
+
+        /// Swap the content with another event list.
+        /**
+            \param list The event list to be swapped with.
+         */
+        void swap(EventList& list) throw()
+        {
+            my_events.swap(list.my_events);
+        }
+
+    private:
+        std::vector<cl_event> my_events;
+}; // class EventList
+
 } // namespace clpp
 
 #endif // CLPP_EVENT_HPP
@@ -6,6 +6,8 @@
 #ifndef CLPP_IMAGE_HPP
 #define CLPP_IMAGE_HPP
 
+#include <utility>
+
 #include "resource.hpp"
 #include "buffer.hpp"
 #include "size.hpp"
@@ -42,21 +44,46 @@ class Image : public Memory {
 
         cl_image_format format() const
         {
-            return getImageInfo<cl_image_format>(CL_IMAGE_FORMAT);
+            return my_format;
         }
 
         size_t width() const
         {
-            return getImageInfo<size_t>(CL_IMAGE_WIDTH);
+            return my_extent.s[0];
         }
 
         size_t height() const
         {
-            return getImageInfo<size_t>(CL_IMAGE_HEIGHT);
+            return my_extent.s[1];
         }
 
     protected:
-        Image(cl_mem id) : Memory(id) {}
+        // The format and extents of an image never change, so they are
+        // queried here once.
+        Image(cl_mem id) : Memory(id), my_extent(0, 0, 0)
+        {
+            my_format.image_channel_order = 0;
+            my_format.image_channel_data_type = 0;
+            if(id != 0){
+                my_format = getImageInfo<cl_image_format>(CL_IMAGE_FORMAT);
+                my_extent.s[0] = getImageInfo<size_t>(CL_IMAGE_WIDTH);
+                my_extent.s[1] = getImageInfo<size_t>(CL_IMAGE_HEIGHT);
+                my_extent.s[2] = getImageInfo<size_t>(CL_IMAGE_DEPTH);
+            }
+        }
+
+        /// Swap the handle and the cached information with another image.
+        void swapImage(Image& mem) throw()
+        {
+            swapMemory(mem);
+            std::swap(my_format, mem.my_format);
+            std::swap(my_extent, mem.my_extent);
+        }
+
+        cl_image_format my_format;
+
+        // The width, height and depth. The depth of a 2D image is 0.
+        size3 my_extent;
 }; // class Image
 
 class Image2D : public Image {
@@ -65,15 +92,12 @@ class Image2D : public Image {
 
         size2 size() const
         {
-            size2 s;
-            s.s[0] = width();
-            s.s[1] = height();
-            return s;
+            return size2(my_extent.s[0], my_extent.s[1]);
         }
 
         void swap(Image2D& mem) throw()
         {
-            my_resource.swap(mem.my_resource);
+            swapImage(mem);
         }
 }; // class Image2D
 
@@ -82,23 +106,19 @@ class Image3D : public Image {
     public:
         Image3D(cl_mem id = 0) : Image(id) {}
 
-        size3 size()
+        size3 size() const
         {
-            size3 s;
-            s.s[0] = width();
-            s.s[1] = height();
-            s.s[2] = depth();
-            return s;
+            return my_extent;
         }
 
         size_t depth() const
         {
-            return getImageInfo<size_t>(CL_IMAGE_DEPTH);
+            return my_extent.s[2];
         }
 
         void swap(Image3D& mem) throw()
         {
-            my_resource.swap(mem.my_resource);
+            swapImage(mem);
         }
 }; // class Image3D
 
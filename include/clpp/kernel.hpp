@@ -6,12 +6,65 @@
 #ifndef CLPP_KERNEL_HPP
 #define CLPP_KERNEL_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "resource.hpp"
 #include "buffer.hpp"
+#include "device.hpp"
+#include "size.hpp"
 #include "error.hpp"
 
 namespace clpp {
 
+/// A local memory argument of a kernel.
+/** Passing a LocalMemory object to Kernel::setArg or Kernel::setArgs
+    allocates \c __local memory of \a count elements for each work-group,
+    for a kernel argument declared as a \c __local pointer, e.g.
+
+    \code
+    kernel void reduce(global const float* in, global float* out, local float* scratch);
+    \endcode
+
+    \code
+    k.setArgs(in, out, LocalMemory<cl_float>(local_size));
+    \endcode
+
+    \tparam T   The element type of the local memory.
+ */
+template <typename T> class LocalMemory {
+    public:
+        typedef T ValueType;
+
+        /// Construct a local memory argument.
+        /**
+            \param count    Number of elements for each work-group.
+         */
+        explicit LocalMemory(size_t count) : my_count(count) {}
+
+        /// Get the number of elements.
+        size_t size() const
+        {
+            return my_count;
+        }
+
+        /// Get the size in bytes.
+        size_t bytes() const
+        {
+            return my_count * sizeof(T);
+        }
+
+    private:
+        size_t my_count;
+}; // template <typename T> class LocalMemory
+
 /// The kernel object.
 /** A kernel is a function declared in a program and executed on an OpenCL
     device. A kernel is identified by the \c __kernel or \c kernel qualifier
@@ -19,11 +72,115 @@ namespace clpp {
  */
 class Kernel {
     public:
+        /// Work-group information of a kernel on a specific device.
+        struct WorkGroupInfo {
+            /// The maximum work-group size which can be used to execute the
+            /// kernel (\c CL_KERNEL_WORK_GROUP_SIZE).
+            size_t work_group_size;
+            /// The work-group size specified by the \c reqd_work_group_size
+            /// attribute, or (0,0,0) if it is not specified
+            /// (\c CL_KERNEL_COMPILE_WORK_GROUP_SIZE).
+            size3 compile_work_group_size;
+            /// The preferred multiple of work-group size
+            /// (\c CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE). It is 1
+            /// if the information is not available.
+            size_t preferred_work_group_size_multiple;
+            /// The amount of local memory in bytes used by the kernel
+            /// (\c CL_KERNEL_LOCAL_MEM_SIZE).
+            cl_ulong local_mem_size;
+            /// The minimum amount of private memory in bytes used by each
+            /// work-item (\c CL_KERNEL_PRIVATE_MEM_SIZE). It is 0 if the
+            /// information is not available.
+            cl_ulong private_mem_size;
+        };
+
+        /// The exception object for oversubscribed local memory.
+        /** It is thrown by checkLocalMemory() before a kernel is launched
+            if the local memory used by the kernel and its LocalMemory
+            arguments exceeds the local memory of the device.
+         */
+        class LocalMemoryError : public Error {
+            public:
+                LocalMemoryError(const char* filename,
+                                 const char* func,
+                                 size_t line,
+                                 const std::string& kernel_name,
+                                 cl_ulong required,
+                                 cl_ulong available)
+                    : Error(CL_OUT_OF_RESOURCES, filename, func, line),
+                      my_required(required), my_available(available)
+                {
+                    std::ostringstream s;
+                    s << "Kernel " << kernel_name << " requires " << required
+                      << " bytes of local memory, but the device has " << available;
+                    my_message = s.str();
+                }
+
+                /// Get the description of the error.
+                virtual const char* what() const throw()
+                {
+                    return my_message.c_str();
+                }
+
+                /// Get the number of bytes of local memory the kernel requires.
+                cl_ulong required() const throw()
+                {
+                    return my_required;
+                }
+
+                /// Get the number of bytes of local memory on the device.
+                cl_ulong available() const throw()
+                {
+                    return my_available;
+                }
+
+                virtual ~LocalMemoryError() throw()
+                {}
+
+            private:
+                cl_ulong my_required;
+                cl_ulong my_available;
+                std::string my_message;
+        };
+
+        /// The exception object for kernel arguments which don't match.
+        /** It is thrown by KernelFunctor when the declared arguments don't
+            match the kernel function.
+         */
+        class ArgumentError : public Error {
+            public:
+                ArgumentError(const char* filename,
+                              const char* func,
+                              size_t line,
+                              const std::string& message)
+                    : Error(CL_INVALID_KERNEL_ARGS, filename, func, line), my_message(message)
+                {}
+
+                /// Get the description of the error.
+                virtual const char* what() const throw()
+                {
+                    return my_message.c_str();
+                }
+
+                virtual ~ArgumentError() throw()
+                {}
+
+            private:
+                std::string my_message;
+        };
+
         /// Construct a kernel object.
         /** Instead of using this constructor directly, please use
             Program::kernel to construct a kernel object.
+
+            Copies of a kernel object share the cache of its arguments, as
+            they share the arguments of the \c cl_kernel object.
          */
-        Kernel(cl_kernel id = 0) : my_resource(id) {}
+        Kernel(cl_kernel id = 0) : my_resource(id)
+        {
+            if(id != 0)
+                my_state.reset(new State);
+        }
 
         /// Get the \c cl_kernel object created by OpenCL API.
         /**
@@ -34,90 +191,283 @@ class Kernel {
             return *my_resource;
         }
 
-        /// Set arguments of this kernel function.
-        template <typename T0>
-        void setArgs(const T0& v0)
+        /// Get the name of the kernel function.
+        /** The name is queried once and remembered by this kernel object and
+            its copies. Kernels created by Program know their names without
+            a query.
+         */
+        const std::string& name() const
         {
-            setArg(0, v0);
+            if(!my_state)
+                CLPP_CHECK_ERROR(CL_INVALID_KERNEL);
+            if(my_state->has_name.load(std::memory_order_acquire))
+                return my_state->name;
+
+            std::lock_guard<std::mutex> lock(my_state->mutex);
+            if(!my_state->has_name.load(std::memory_order_relaxed)){
+                size_t len;
+                cl_int err = clGetKernelInfo(id(), CL_KERNEL_FUNCTION_NAME, 0, NULL, &len);
+                CLPP_CHECK_ERROR(err);
+                std::string buf(len, 0);
+                err = clGetKernelInfo(id(), CL_KERNEL_FUNCTION_NAME, len, &buf[0], NULL);
+                CLPP_CHECK_ERROR(err);
+                my_state->name = buf.c_str();
+                my_state->has_name.store(true, std::memory_order_release);
+            }
+            return my_state->name;
         }
 
-        /// Set arguments of this kernel function.
-        template <typename T0, typename T1>
-        void setArgs(const T0& v0, const T1& v1)
+        /// Get the number of arguments of the kernel function.
+        cl_uint numArgs() const
         {
-            setArg(1, v1);
-            setArgs(v0);
+            cl_uint num;
+            cl_int err = clGetKernelInfo(id(), CL_KERNEL_NUM_ARGS, sizeof(num), &num, NULL);
+            CLPP_CHECK_ERROR(err);
+            return num;
         }
 
         /// Set arguments of this kernel function.
-        template <typename T0, typename T1, typename T2>
-        void setArgs(const T0& v0, const T1& v1, const T2& v2)
+        /** The arguments are set from index 0 in order, by setArg(). Any
+            number of arguments is supported.
+
+            Arguments whose value is the same as the last value set at the
+            same index are skipped, so setting all arguments before every
+            launch only costs OpenCL calls for those which changed.
+         */
+        template <typename... Args> void setArgs(const Args&... args)
         {
-            setArg(2, v2);
-            setArgs(v0, v1);
+            setArgsFrom(0, args...);
         }
 
-        /// Set arguments of this kernel function.
-        template <typename T0, typename T1, typename T2, typename T3>
-        void setArgs(const T0& v0, const T1& v1, const T2& v2, const T3& v3)
+        /// Set a specific argument of this kernel function.
+        /** The argument is not set again if its bytes are the same as the
+            last value set at \a arg_index on this kernel object or its
+            copies.
+
+            \tparam T           The type of the argument.
+            \param arg_index    The index of specified argument.
+            \param value        The argument value.
+         */
+        template <typename T> void setArg(cl_uint arg_index, const T& value)
         {
-            setArg(3, v3);
-            setArgs(v0, v1, v2);
+            bind(arg_index, sizeof(T), &value, 0);
         }
 
         /// Set arguments of this kernel function.
-        template <typename T0, typename T1, typename T2, typename T3, typename T4>
-        void setArgs(const T0& v0, const T1& v1, const T2& v2, const T3& v3, const T4& v4)
+        /** This function is a specialized version which is used for
+            buffer objects. The kernel doesn't keep the buffer alive. The
+            cached argument is compared by Memory::generation(), so a new
+            buffer which gets the handle of a released one is still set.
+         */
+        template<typename T> void setArg(cl_uint arg_index, const Buffer<T>& memory)
         {
-            setArg(4, v4);
-            setArgs(v0, v1, v2, v3);
+            cl_mem mem = memory.id();
+            bind(arg_index, sizeof(cl_mem), &mem, memory.generation());
         }
 
         /// Set arguments of this kernel function.
-        template <typename T0, typename T1, typename T2, typename T3, typename T4, typename T5>
-        void setArgs(const T0& v0, const T1& v1, const T2& v2, const T3& v3, const T4& v4, const T5& v5)
+        /** This function is a specialized version which is used for
+            buffer views. If the view is not backed by a sub-buffer object,
+            the whole parent buffer is bound, and BufferView::offset() must
+            be passed to the kernel as another argument.
+         */
+        template<typename T> void setArg(cl_uint arg_index, const BufferView<T>& view)
         {
-            setArg(5, v5);
-            setArgs(v0, v1, v2, v3, v4);
+            setArg(arg_index, view.buffer());
         }
 
         /// Set arguments of this kernel function.
-        template <typename T0, typename T1, typename T2, typename T3, typename T4, typename T5, typename T6>
-        void setArgs(const T0& v0, const T1& v1, const T2& v2, const T3& v3, const T4& v4, const T5& v5, const T6& v6)
+        /** This function is a specialized version which is used for
+            local memory. The memory is allocated for each work-group when
+            the kernel is executed.
+         */
+        template<typename T> void setArg(cl_uint arg_index, const LocalMemory<T>& local)
         {
-            setArg(6, v6);
-            setArgs(v0, v1, v2, v3, v4, v5);
+            bind(arg_index, local.bytes(), NULL, 0);
         }
 
-        /// Set arguments of this kernel function.
-        template <typename T0, typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7>
-        void setArgs(const T0& v0, const T1& v1, const T2& v2, const T3& v3, const T4& v4, const T5& v5, const T6& v6, const T7& v7)
+        /// Forget the cached arguments.
+        /** The next setArg() at every index calls OpenCL. Call this
+            function after setting arguments of id() directly by
+            \c clSetKernelArg.
+         */
+        void clearArgCache()
         {
-            setArg(7, v7);
-            setArgs(v0, v1, v2, v3, v4, v5, v6);
+            if(my_state){
+                my_state->args.clear();
+                my_state->local_bytes = 0;
+            }
         }
 
-        /// Set a specific argument of this kernel function.
-        /** 
-            \tparam T           The type of the argument.
-            \param arg_index    The index of specified argument.
-            \param value        The argument value.
+        /// Get the total size of the LocalMemory arguments.
+        /**
+            \return     The sum of bytes of all LocalMemory arguments set on
+                        this kernel object and its copies.
          */
-        template <typename T> void setArg(cl_uint arg_index, const T& value)
+        size_t localArgSize() const
         {
-            cl_int err = clSetKernelArg(id(), arg_index, sizeof(T), &value);
+            return my_state ? my_state->local_bytes : 0;
+        }
+
+        /// Check that the local memory used by this kernel fits in a device.
+        /** The required size is \c CL_KERNEL_LOCAL_MEM_SIZE, which includes
+            statically declared \c __local variables, or localArgSize() if
+            that is larger, because some implementations don't count
+            arguments. The result is remembered until the LocalMemory
+            arguments change, so CommandQueue::exec calls this function
+            before every launch of a kernel with LocalMemory arguments.
+
+            \param device   The device where the kernel will be executed.
+            \throw LocalMemoryError if the device doesn't have enough local
+                                    memory.
+         */
+        void checkLocalMemory(const Device& device) const
+        {
+            size_t bytes = 0;
+            if(my_state){
+                std::lock_guard<std::mutex> lock(my_state->mutex);
+                bytes = my_state->local_bytes;
+                if(my_state->checked_device == device.id() && my_state->checked_bytes == bytes)
+                    return;
+            }
+
+            // Query without the lock, so other threads can launch meanwhile.
+            cl_ulong required = std::max<cl_ulong>(getWorkGroupInfo<cl_ulong>(device, CL_KERNEL_LOCAL_MEM_SIZE), bytes);
+            cl_ulong available = device.getLocalMemSize();
+            if(required > available)
+                throw LocalMemoryError(__FILE__, __FUNCTION__, __LINE__, name(), required, available);
+
+            if(my_state){
+                std::lock_guard<std::mutex> lock(my_state->mutex);
+                my_state->checked_device = device.id();
+                my_state->checked_bytes = bytes;
+            }
+        }
+
+        /// Get work-group information of this kernel on a specific device.
+        /**
+            \tparam T       The type of queried information.
+            \param device   The device where the kernel will be executed.
+            \param info     Specifies the information to query.
+            \return         The queried value.
+         */
+        template <typename T> T getWorkGroupInfo(Device device, cl_kernel_work_group_info info) const
+        {
+            T result;
+            cl_int err = clGetKernelWorkGroupInfo(id(), device.id(), info, sizeof(T), &result, NULL);
             CLPP_CHECK_ERROR(err);
+            return result;
         }
 
-        /// Set arguments of this kernel function.
-        /** This function is a specialized version which is used for
-            buffer objects.
+        /// Get all work-group information of this kernel on a specific device.
+        /** The information is queried once per device and remembered by
+            this kernel object and its copies.
+
+            \param device   The device where the kernel will be executed.
+            \return         The work-group information.
          */
-        template<typename T> void setArg(cl_uint arg_index, const Buffer<T>& memory)
+        WorkGroupInfo workGroupInfo(const Device& device) const
         {
-            cl_mem mem = memory.id();
-            cl_int err = clSetKernelArg(id(), arg_index, sizeof(cl_mem), &mem);
+            if(!my_state)
+                return queryWorkGroupInfo(device);
+
+            {
+                std::lock_guard<std::mutex> lock(my_state->mutex);
+                const State::DeviceCache* c = my_state->find(device.id());
+                if(c)
+                    return c->info;
+            }
+            WorkGroupInfo info = queryWorkGroupInfo(device);
+            std::lock_guard<std::mutex> lock(my_state->mutex);
+            my_state->cache(device.id()).info = info;
+            return info;
+        }
+
+        /// Choose a work-group size for this kernel.
+        /** The work-group size is derived from workGroupInfo() and
+            Device::getMaxWorkItemSizes(). The first dimension is a multiple
+            of the preferred work-group size multiple, and the remaining
+            budget of work-items is given to the other dimensions. If the
+            kernel specifies \c reqd_work_group_size, that size is used.
+
+            The global size should be padded to a multiple of the chosen
+            size, so the kernel must check its global ID against the actual
+            problem size.
+
+            The size chosen for the last global size on each device is
+            remembered, so launching again with the same sizes makes no
+            OpenCL calls.
+
+            \param device       The device where the kernel will be executed.
+            \param dim          The number of dimensions, from 1 to 3.
+            \param global_size  The global size in each dimension.
+            \param local_size   Receives the work-group size in each
+                                dimension.
+         */
+        void selectLocalSize(const Device& device, cl_uint dim, const size_t* global_size, size_t* local_size) const
+        {
+            if(my_state){
+                std::lock_guard<std::mutex> lock(my_state->mutex);
+                const State::DeviceCache* c = my_state->find(device.id());
+                if(c && c->selected_dim == dim && std::equal(global_size, global_size + dim, c->selected_global.s)){
+                    std::copy(c->selected_local.s, c->selected_local.s + dim, local_size);
+                    return;
+                }
+            }
+
+            computeLocalSize(device, dim, global_size, local_size);
+
+            if(my_state){
+                std::lock_guard<std::mutex> lock(my_state->mutex);
+                State::DeviceCache& c = my_state->cache(device.id());
+                c.selected_dim = dim;
+                std::copy(global_size, global_size + dim, c.selected_global.s);
+                std::copy(local_size, local_size + dim, c.selected_local.s);
+            }
+        }
+
+        /// Create an independent instance of this kernel.
+        /** The new kernel object has its own arguments, initialized with
+            the arguments set through setArg() on this kernel object or its
+            copies: values, LocalMemory sizes and buffers. Buffers are copied
+            by handle and not retained, so they must not have been released
+            when clone() is called. Arguments set on id() directly by
+            \c clSetKernelArg are only copied on OpenCL 2.1, where
+            \c clCloneKernel is used. Otherwise the kernel is created again
+            from its program.
+
+            \return     The new kernel object.
+         */
+        Kernel clone() const
+        {
+            cl_int err;
+#ifdef CL_VERSION_2_1
+            cl_kernel k = clCloneKernel(id(), &err);
+            CLPP_CHECK_ERROR(err);
+            Kernel result(k);
+            if(my_state)
+                result.my_state->assignArgs(*my_state);
+#else
+            cl_program program;
+            err = clGetKernelInfo(id(), CL_KERNEL_PROGRAM, sizeof(program), &program, NULL);
             CLPP_CHECK_ERROR(err);
+            const std::string& kernel_name = name();
+            cl_kernel k = clCreateKernel(program, kernel_name.c_str(), &err);
+            CLPP_CHECK_ERROR(err);
+            Kernel result(k, kernel_name);
+            if(my_state){
+                const std::vector<State::Arg>& args = my_state->args;
+                for(size_t i = 0; i < args.size(); ++i){
+                    if(!args[i].set)
+                        continue;
+                    const void* value = args[i].bytes.empty() ? NULL : &args[i].bytes[0];
+                    err = clSetKernelArg(k, static_cast<cl_uint>(i), args[i].size, value);
+                    CLPP_CHECK_ERROR(err);
+                }
+                result.my_state->assignArgs(*my_state);
+            }
+#endif
+            return result;
         }
 
         /// Swap the pointed content with another kernel object.
@@ -127,12 +477,347 @@ class Kernel {
         void swap(Kernel& k) throw()
         {
             my_resource.swap(k.my_resource);
+            my_state.swap(k.my_state);
+            my_lease.swap(k.my_lease);
         }
 
     private:
+        friend class Program;
+        friend class ThreadLocalKernel;
+
+        // Retain the buffers bound through setArg(), so that their handles
+        // stay valid for later clones.
+        std::vector< Resource<cl_mem> > retainBufferArgs() const
+        {
+            std::vector< Resource<cl_mem> > result;
+            if(!my_state)
+                return result;
+            const std::vector<State::Arg>& args = my_state->args;
+            for(size_t i = 0; i < args.size(); ++i){
+                if(!args[i].set || args[i].generation == 0)
+                    continue;
+                cl_mem mem;
+                std::memcpy(&mem, &args[i].bytes[0], sizeof(mem));
+                if(mem == 0)
+                    continue;
+                CLPP_CHECK_ERROR( ResourcePolicy<cl_mem>::retain(mem) );
+                result.push_back(Resource<cl_mem>(mem));
+            }
+            return result;
+        }
+
+        WorkGroupInfo queryWorkGroupInfo(const Device& device) const
+        {
+            WorkGroupInfo info;
+            info.work_group_size = getWorkGroupInfo<size_t>(device, CL_KERNEL_WORK_GROUP_SIZE);
+            cl_int err = clGetKernelWorkGroupInfo(id(), device.id(), CL_KERNEL_COMPILE_WORK_GROUP_SIZE, sizeof(info.compile_work_group_size.s), info.compile_work_group_size.s, NULL);
+            CLPP_CHECK_ERROR(err);
+            info.local_mem_size = getWorkGroupInfo<cl_ulong>(device, CL_KERNEL_LOCAL_MEM_SIZE);
+#ifdef CL_VERSION_1_1
+            info.preferred_work_group_size_multiple = getWorkGroupInfo<size_t>(device, CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE);
+            info.private_mem_size = getWorkGroupInfo<cl_ulong>(device, CL_KERNEL_PRIVATE_MEM_SIZE);
+#else
+            info.preferred_work_group_size_multiple = 1;
+            info.private_mem_size = 0;
+#endif
+            return info;
+        }
+
+        void computeLocalSize(const Device& device, cl_uint dim, const size_t* global_size, size_t* local_size) const
+        {
+            WorkGroupInfo info = workGroupInfo(device);
+            const size_t* required = info.compile_work_group_size.s;
+            if(required[0] != 0){
+                for(cl_uint d = 0; d < dim; ++d)
+                    local_size[d] = required[d];
+                return;
+            }
+
+            std::vector<size_t> max_items = device.getMaxWorkItemSizes();
+            size_t budget = info.work_group_size;
+            size_t multiple = info.preferred_work_group_size_multiple;
+            if(multiple == 0 || multiple > budget)
+                multiple = 1;
+
+            // First dimension: the largest multiple of the preferred size
+            // which fits, without exceeding the padded global size.
+            size_t l = std::min(budget, max_items[0]);
+            if(l >= multiple)
+                l -= l % multiple;
+            size_t padded = (global_size[0] + multiple - 1) / multiple * multiple;
+            if(padded != 0 && padded < l)
+                l = padded;
+            local_size[0] = std::max<size_t>(l, 1);
+            budget /= local_size[0];
+
+            // Other dimensions: powers of two from the remaining budget.
+            for(cl_uint d = 1; d < dim; ++d){
+                size_t limit = std::min(budget, d < max_items.size() ? max_items[d] : 1);
+                size_t p = 1;
+                while(p*2 <= limit && p < global_size[d])
+                    p *= 2;
+                local_size[d] = p;
+                budget /= p;
+            }
+        }
+
+
+        // A kernel checked out of the cache of a Program. The lease returns
+        // the kernel to the cache when the last copy is destroyed.
+        Kernel(const Kernel& k, const std::shared_ptr<void>& lease)
+            : my_resource(k.my_resource), my_state(k.my_state), my_lease(lease)
+        {}
+
+        // Construct a kernel whose function name is known.
+        Kernel(cl_kernel id, const std::string& name) : my_resource(id)
+        {
+            if(id != 0){
+                my_state.reset(new State);
+                my_state->name = name;
+                my_state->has_name = true;
+            }
+        }
+
+        // Arguments are shared by all copies of a kernel object, so their
+        // record is shared too.
+        struct State {
+            // The last value set at an argument index.
+            struct Arg {
+                Arg() : set(false), size(0), generation(0) {}
+
+                bool set;
+                // The size in bytes. A LocalMemory argument has no bytes.
+                size_t size;
+                std::vector<unsigned char> bytes;
+                // The generation of the bound memory object, or 0.
+                cl_ulong generation;
+            };
+
+            // What is known about the kernel on a device.
+            struct DeviceCache {
+                DeviceCache() : device(0), selected_dim(0) {}
+
+                cl_device_id device;
+                WorkGroupInfo info;
+                // The last global size given to selectLocalSize() and the
+                // chosen work-group size.
+                cl_uint selected_dim;
+                size3 selected_global;
+                size3 selected_local;
+            };
+
+            State() : local_bytes(0), checked_device(0), checked_bytes(0), has_name(false) {}
+
+            // Copy the arguments of another kernel, but not what is cached
+            // about the kernel itself.
+            void assignArgs(const State& s)
+            {
+                args = s.args;
+                local_bytes = s.local_bytes;
+            }
+
+            // Find the cache of a device, or NULL. The mutex must be locked.
+            const DeviceCache* find(cl_device_id device) const
+            {
+                for(size_t i = 0; i < devices.size(); ++i)
+                    if(devices[i].device == device)
+                        return &devices[i];
+                return NULL;
+            }
+
+            // Get the cache of a device, adding it if necessary. The mutex
+            // must be locked. A new cache has its work-group information
+            // queried by workGroupInfo().
+            DeviceCache& cache(cl_device_id device)
+            {
+                for(size_t i = 0; i < devices.size(); ++i)
+                    if(devices[i].device == device)
+                        return devices[i];
+                devices.push_back(DeviceCache());
+                devices.back().device = device;
+                return devices.back();
+            }
+
+            std::vector<Arg> args;
+
+            // The sum of sizes of LocalMemory arguments.
+            size_t local_bytes;
+
+            // The device and local_bytes of the last successful
+            // checkLocalMemory(), guarded by mutex.
+            cl_device_id checked_device;
+            size_t checked_bytes;
+
+            // Guards the caches below. Arguments are not guarded, since
+            // threads setting arguments of one kernel need a lock anyway.
+            std::mutex mutex;
+            std::vector<DeviceCache> devices;
+
+            // The function name. It is only written once, under the mutex,
+            // before has_name is set.
+            std::atomic<bool> has_name;
+            std::string name;
+        };
+
+        void setArgsFrom(cl_uint)
+        {
+        }
+
+        template <typename T, typename... Rest> void setArgsFrom(cl_uint arg_index, const T& value, const Rest&... rest)
+        {
+            setArg(arg_index, value);
+            setArgsFrom(arg_index + 1, rest...);
+        }
+
+        // Set an argument unless it is unchanged. value is NULL for local
+        // memory, and generation is the Memory::generation() of a memory
+        // object, or 0.
+        void bind(cl_uint arg_index, size_t size, const void* value, cl_ulong generation)
+        {
+            if(!my_state){
+                CLPP_CHECK_ERROR( clSetKernelArg(id(), arg_index, size, value) );
+                return;
+            }
+
+            std::vector<State::Arg>& args = my_state->args;
+            if(arg_index >= args.size())
+                args.resize(arg_index + 1);
+            State::Arg& a = args[arg_index];
+            bool local = value == NULL;
+            if(a.set && a.size == size && a.bytes.empty() == local && a.generation == generation
+               && (local || std::memcmp(&a.bytes[0], value, size) == 0))
+                return;
+
+            // Forget the old value first, so that a failure leaves the
+            // argument unknown rather than wrong.
+            if(a.set && a.bytes.empty())
+                my_state->local_bytes -= a.size;
+            a.set = false;
+            CLPP_CHECK_ERROR( clSetKernelArg(id(), arg_index, size, value) );
+
+            a.generation = generation;
+            if(local){
+                a.bytes.clear();
+                my_state->local_bytes += size;
+            }else{
+                const unsigned char* p = static_cast<const unsigned char*>(value);
+                a.bytes.assign(p, p + size);
+            }
+            a.size = size;
+            a.set = true;
+        }
+
         Resource<cl_kernel> my_resource;
+        std::shared_ptr<State> my_state;
+        std::shared_ptr<void> my_lease;
 }; // class Kernel
 
+/// A kernel with an independent instance for each thread.
+/** Arguments of a kernel object are shared by all threads which use it, so
+    threads which set arguments and launch the same Kernel concurrently
+    need a lock around both. A ThreadLocalKernel instead gives every thread
+    its own instance, created by Kernel::clone() the first time the thread
+    calls get(), so many threads can set arguments and launch without any
+    lock. Later calls of get() in the same thread don't lock either.
+
+    \code
+    ThreadLocalKernel tk(program.kernel("scale"));
+    // in each worker thread
+    Kernel& k = tk.get();
+    k.setArgs(buffer, factor);
+    queue.exec(k, n);
+    \endcode
+
+    Every instance starts with all arguments set on the prototype through
+    Kernel::setArg(), as copied by Kernel::clone(). Buffers bound to the
+    prototype are retained by the ThreadLocalKernel, so instances created
+    later still bind them, even if the application has released its Buffer
+    objects.
+
+    The instances are released when the ThreadLocalKernel is destroyed,
+    which must not happen while other threads still use them.
+ */
+class ThreadLocalKernel {
+    public:
+        /// Construct a thread-local kernel.
+        /**
+            \param prototype    The kernel which is cloned for every thread.
+                                Arguments set on it so far are inherited by
+                                every instance.
+         */
+        explicit ThreadLocalKernel(const Kernel& prototype)
+            : my_prototype(prototype.clone()), my_buffers(my_prototype.retainBufferArgs()), my_key(nextKey())
+        {}
+
+        /// Get the kernel instance of the calling thread.
+        Kernel& get()
+        {
+            // Each thread maps the keys of thread-local kernels to its
+            // instances. Keys are never reused, so an entry found here
+            // belongs to this object, which is alive. Entries of destroyed
+            // objects are swept when the map has doubled since the last
+            // sweep.
+            static thread_local Instances instances;
+            static thread_local size_t sweep_size = 16;
+            Instances::iterator i = instances.find(my_key);
+            if(i != instances.end())
+                return *i->second.kernel;
+
+            if(instances.size() >= sweep_size){
+                for(i = instances.begin(); i != instances.end(); ){
+                    if(i->second.owner.expired())
+                        i = instances.erase(i);
+                    else
+                        ++i;
+                }
+                sweep_size = std::max<size_t>(16, 2*instances.size());
+            }
+
+            std::shared_ptr<Kernel> k = std::make_shared<Kernel>(my_prototype.clone());
+            {
+                std::lock_guard<std::mutex> lock(my_mutex);
+                my_instances.push_back(k);
+            }
+            Instance& entry = instances[my_key];
+            entry.kernel = k.get();
+            entry.owner = k;
+            return *k;
+        }
+
+        /// Get the number of instances created so far.
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            return my_instances.size();
+        }
+
+    private:
+        // An instance seen by a thread, which expires with its owner.
+        struct Instance {
+            Kernel* kernel;
+            std::weak_ptr<Kernel> owner;
+        };
+
+        typedef std::unordered_map<unsigned long long, Instance> Instances;
+
+        static unsigned long long nextKey()
+        {
+            static std::atomic<unsigned long long> key(0);
+            return ++key;
+        }
+
+        ThreadLocalKernel(const ThreadLocalKernel&);
+        ThreadLocalKernel& operator=(const ThreadLocalKernel&);
+
+        Kernel my_prototype;
+        // The buffers bound to my_prototype, retained for instances created
+        // after the application has released them.
+        std::vector< Resource<cl_mem> > my_buffers;
+        unsigned long long my_key;
+        mutable std::mutex my_mutex;
+        std::vector< std::shared_ptr<Kernel> > my_instances;
+}; // class ThreadLocalKernel
+
 } // namespace clpp
 
 #endif // CLPP_KERNEL_HPP
@@ -0,0 +1,310 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_KERNELFUNCTOR_HPP
+#define CLPP_KERNELFUNCTOR_HPP
+
+#include <sstream>
+#include <string>
+
+#include "common.hpp"
+#include "error.hpp"
+#include "size.hpp"
+#include "buffer.hpp"
+#include "event.hpp"
+#include "kernel.hpp"
+#include "program.hpp"
+#include "commandqueue.hpp"
+#include "typename.hpp"
+
+namespace clpp {
+
+/// The global and local sizes of a kernel execution.
+/** A range has one, two or three dimensions. A local size of 0 in any
+    dimension lets the OpenCL implementation choose the work-group size, as
+    in CommandQueue::exec.
+ */
+class NDRange {
+    public:
+        /// Construct a 1-D range.
+        NDRange(size_t global_size, size_t local_size = 0)
+            : my_dim(1), my_global(global_size, 1, 1), my_local(local_size, 1, 1)
+        {}
+
+        /// Construct a 2-D range.
+        NDRange(size2 global_size, size2 local_size = size2(0))
+            : my_dim(2), my_global(global_size.s[0], global_size.s[1], 1),
+              my_local(local_size.s[0], local_size.s[1], 1)
+        {}
+
+        /// Construct a 3-D range.
+        NDRange(size3 global_size, size3 local_size = size3(0))
+            : my_dim(3), my_global(global_size), my_local(local_size)
+        {}
+
+        /// Get the number of dimensions.
+        cl_uint dim() const
+        {
+            return my_dim;
+        }
+
+        /// Get the global size. Unused dimensions are 1.
+        const size3& global() const
+        {
+            return my_global;
+        }
+
+        /// Get the local size. Unused dimensions are 1.
+        const size3& local() const
+        {
+            return my_local;
+        }
+
+        /// Execute a kernel over this range.
+        Event exec(CommandQueue& queue, const Kernel& k, const EventList& wait_list = EventList()) const
+        {
+            switch(my_dim){
+                case 1:
+                    return queue.exec(k, my_global.s[0], my_local.s[0], wait_list);
+                case 2:
+                    return queue.exec(k, size2(my_global.s[0], my_global.s[1]), size2(my_local.s[0], my_local.s[1]), wait_list);
+                default:
+                    return queue.exec(k, my_global, my_local, wait_list);
+            }
+        }
+
+    private:
+        cl_uint my_dim;
+        size3 my_global;
+        size3 my_local;
+}; // class NDRange
+
+#ifdef CL_VERSION_1_2
+/// Describes how a host argument type is passed to a kernel.
+/** The primary template describes values passed by copy. The
+    specializations describe buffers and local memory.
+ */
+template <typename T> struct KernelArgTraits {
+    /// Check the address space of the kernel parameter.
+    static bool matches(cl_kernel_arg_address_qualifier q)
+    {
+        return q == CL_KERNEL_ARG_ADDRESS_PRIVATE;
+    }
+
+    /// Get the OpenCL C type name of the kernel parameter, or an empty
+    /// string if it is unknown.
+    static std::string typeName()
+    {
+        return TypeName<T>::name() ? TypeName<T>::name() : "";
+    }
+
+    /// Describe the declared argument for error messages.
+    static std::string describe()
+    {
+        return "a value" + (typeName().empty() ? std::string() : " of type " + typeName());
+    }
+};
+
+template <typename T> struct KernelArgTraits< Buffer<T> > {
+    static bool matches(cl_kernel_arg_address_qualifier q)
+    {
+        return q == CL_KERNEL_ARG_ADDRESS_GLOBAL || q == CL_KERNEL_ARG_ADDRESS_CONSTANT;
+    }
+
+    static std::string typeName()
+    {
+        return TypeName<T>::name() ? std::string(TypeName<T>::name()) + "*" : "";
+    }
+
+    static std::string describe()
+    {
+        return "a buffer" + (TypeName<T>::name() ? std::string(" of ") + TypeName<T>::name() : std::string());
+    }
+};
+
+template <typename T> struct KernelArgTraits< BufferView<T> > : KernelArgTraits< Buffer<T> > {};
+
+template <typename T> struct KernelArgTraits< LocalMemory<T> > {
+    static bool matches(cl_kernel_arg_address_qualifier q)
+    {
+        return q == CL_KERNEL_ARG_ADDRESS_LOCAL;
+    }
+
+    static std::string typeName()
+    {
+        return KernelArgTraits< Buffer<T> >::typeName();
+    }
+
+    static std::string describe()
+    {
+        return "local memory" + (TypeName<T>::name() ? std::string(" of ") + TypeName<T>::name() : std::string());
+    }
+};
+#endif
+
+/// A kernel function with a declared signature.
+/** A kernel functor binds all arguments and executes the kernel in one
+    call, e.g.
+
+    \code
+    KernelFunctor<Buffer<cl_float>, Buffer<cl_float>, cl_uint> scale(program, "scale");
+    Event e = scale(queue, NDRange(n, 64), in, out, cl_uint(n));
+    \endcode
+
+    Arguments are checked against \a Args at compile time. At construction,
+    the number of arguments is checked against the kernel function. If the
+    program was built with \c -cl-kernel-arg-info on OpenCL 1.2, the address
+    space and, for OpenCL C built-in types, the type of each argument are
+    checked too. Kernel::ArgumentError is thrown if they don't match.
+
+    Binding is done by Kernel::setArgs, so unchanged arguments are not set
+    again. Like a Kernel, a functor must not be called by several threads at
+    the same time.
+
+    \tparam Args    The host types of the kernel arguments, e.g.
+                    Buffer<cl_float>, LocalMemory<cl_float> or cl_int.
+ */
+template <typename... Args> class KernelFunctor {
+    public:
+        /// Construct a functor for a kernel function in a program.
+        /**
+            \param program      The built program.
+            \param kernel_name  The name of the kernel function.
+         */
+        KernelFunctor(Program program, const char* kernel_name)
+            : my_kernel(program.kernel(kernel_name))
+        {
+            check();
+        }
+
+        /// Construct a functor for a kernel object.
+        explicit KernelFunctor(const Kernel& kernel) : my_kernel(kernel)
+        {
+            check();
+        }
+
+        /// Get the kernel object.
+        const Kernel& kernel() const
+        {
+            return my_kernel;
+        }
+
+        /// Bind the arguments and execute the kernel.
+        /**
+            \param queue    The command queue where the kernel is executed.
+            \param range    The global and local sizes.
+            \param args     The kernel arguments.
+
+            \return         The event of the kernel execution.
+         */
+        Event operator()(CommandQueue& queue, const NDRange& range, const Args&... args)
+        {
+            my_kernel.setArgs(args...);
+            return range.exec(queue, my_kernel);
+        }
+
+        /// Bind the arguments and execute the kernel after some events.
+        /**
+            \param queue        The command queue where the kernel is
+                                executed.
+            \param range        The global and local sizes.
+            \param wait_list    Events that need to complete before the
+                                kernel can be executed.
+            \param args         The kernel arguments.
+
+            \return             The event of the kernel execution.
+         */
+        Event operator()(CommandQueue& queue, const NDRange& range, const EventList& wait_list, const Args&... args)
+        {
+            my_kernel.setArgs(args...);
+            return range.exec(queue, my_kernel, wait_list);
+        }
+
+    private:
+        void check()
+        {
+            cl_uint num = my_kernel.numArgs();
+            if(num != sizeof...(Args)){
+                std::ostringstream s;
+                s << "Kernel " << my_kernel.name() << " takes " << num
+                  << " arguments, but " << sizeof...(Args) << " are declared";
+                throw Kernel::ArgumentError(__FILE__, __FUNCTION__, __LINE__, s.str());
+            }
+#ifdef CL_VERSION_1_2
+            cl_uint index = 0;
+            bool available = true;
+            int expand[] = { 0, (checkArg<Args>(index++, available), 0)... };
+            (void)expand;
+            (void)available;
+#endif
+        }
+
+#ifdef CL_VERSION_1_2
+        // Check an argument by clGetKernelArgInfo. It stops checking once
+        // the information turns out to be unavailable.
+        template <typename T> void checkArg(cl_uint index, bool& available)
+        {
+            if(!available)
+                return;
+
+            cl_kernel_arg_address_qualifier q;
+            cl_int err = clGetKernelArgInfo(my_kernel.id(), index, CL_KERNEL_ARG_ADDRESS_QUALIFIER, sizeof(q), &q, NULL);
+            if(err == CL_KERNEL_ARG_INFO_NOT_AVAILABLE){
+                available = false;
+                return;
+            }
+            CLPP_CHECK_ERROR(err);
+
+            std::string type = argTypeName(index);
+            std::string expected = KernelArgTraits<T>::typeName();
+            if(!KernelArgTraits<T>::matches(q) || (!expected.empty() && type != expected)){
+                std::ostringstream s;
+                s << "Argument " << index << " of kernel " << my_kernel.name()
+                  << " is " << addressName(q) << ' ' << type
+                  << ", but " << KernelArgTraits<T>::describe() << " is declared";
+                throw Kernel::ArgumentError(__FILE__, __FUNCTION__, __LINE__, s.str());
+            }
+        }
+
+        // The type name without spaces, with "unsigned " written as "u".
+        std::string argTypeName(cl_uint index) const
+        {
+            size_t len;
+            cl_int err = clGetKernelArgInfo(my_kernel.id(), index, CL_KERNEL_ARG_TYPE_NAME, 0, NULL, &len);
+            CLPP_CHECK_ERROR(err);
+            std::string buf(len, 0);
+            err = clGetKernelArgInfo(my_kernel.id(), index, CL_KERNEL_ARG_TYPE_NAME, len, &buf[0], NULL);
+            CLPP_CHECK_ERROR(err);
+
+            std::string name;
+            for(const char* p = buf.c_str(); *p; ++p)
+                if(*p != ' ')
+                    name += *p;
+            if(name.compare(0, 8, "unsigned") == 0)
+                name = "u" + name.substr(8);
+            return name;
+        }
+
+        static const char* addressName(cl_kernel_arg_address_qualifier q)
+        {
+            switch(q){
+                case CL_KERNEL_ARG_ADDRESS_GLOBAL:
+                    return "global";
+                case CL_KERNEL_ARG_ADDRESS_LOCAL:
+                    return "local";
+                case CL_KERNEL_ARG_ADDRESS_CONSTANT:
+                    return "constant";
+                default:
+                    return "private";
+            }
+        }
+#endif
+
+        Kernel my_kernel;
+}; // template <typename... Args> class KernelFunctor
+
+} // namespace clpp
+
+#endif // CLPP_KERNELFUNCTOR_HPP
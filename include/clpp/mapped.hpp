@@ -0,0 +1,181 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_MAPPED_HPP
+#define CLPP_MAPPED_HPP
+
+#include <utility>
+
+#include "resource.hpp"
+#include "buffer.hpp"
+#include "event.hpp"
+#include "error.hpp"
+
+namespace clpp {
+
+/// A mapped region of a buffer object.
+/** A mapped range gives the host direct access to a region of a buffer
+    object through a contiguous range of pointers. The region is unmapped
+    when the range is destroyed, or explicitly by unmap(). On devices which
+    share memory with the host, e.g. CPU devices, and for buffers created
+    with \c CL_MEM_ALLOC_HOST_PTR or \c CL_MEM_USE_HOST_PTR, mapping doesn't
+    copy any data.
+
+    If the range is mapped by a non-blocking map, the pointers must not be
+    accessed before event() is complete. Use wait() to wait for it.
+
+    A mapped range can be moved but not copied.
+ */
+template <typename T> class MappedRange {
+    public:
+        typedef T ValueType;
+        typedef T* Iterator;
+        typedef const T* ConstIterator;
+
+        /// Construct an empty range.
+        MappedRange() : my_ptr(NULL), my_count(0) {}
+
+        /// Construct a mapped range.
+        /** Please use CommandQueue::map instead of using this constructor
+            directly.
+
+            \param queue    The command queue which mapped the region. It is
+                            retained by the range.
+            \param buffer   The mapped buffer object.
+            \param ptr      The mapped pointer returned by OpenCL.
+            \param count    The number of mapped elements.
+            \param event    The event of the map command.
+         */
+        MappedRange(cl_command_queue queue, const Buffer<T>& buffer, T* ptr, size_t count, const Event& event)
+            : my_buffer(buffer), my_ptr(ptr), my_count(count), my_event(event)
+        {
+            cl_int err = clRetainCommandQueue(queue);
+            if(err != CL_SUCCESS){
+                clEnqueueUnmapMemObject(queue, buffer.id(), ptr, 0, NULL, NULL);
+                CLPP_CHECK_ERROR(err);
+            }
+            my_queue.reset(queue);
+        }
+
+        MappedRange(MappedRange&& r) throw()
+            : my_queue(std::move(r.my_queue)), my_buffer(std::move(r.my_buffer)),
+              my_ptr(r.my_ptr), my_count(r.my_count), my_event(std::move(r.my_event))
+        {
+            r.my_ptr = NULL;
+            r.my_count = 0;
+        }
+
+        MappedRange& operator=(MappedRange&& r) throw()
+        {
+            MappedRange tmp(std::move(r));
+            swap(tmp);
+            return *this;
+        }
+
+        /// Unmap the region if it is still mapped.
+        ~MappedRange() throw()
+        {
+            if(my_ptr != NULL)
+                clEnqueueUnmapMemObject(*my_queue, my_buffer.id(), my_ptr, 0, NULL, NULL);
+        }
+
+        /// Unmap the region.
+        /** After this function returns, the range is empty.
+
+            \param wait_list    Events that need to complete before the
+                                region is unmapped.
+            \return             The event of the unmap command.
+         */
+        Event unmap(const EventList& wait_list = EventList())
+        {
+            if(my_ptr == NULL)
+                return Event();
+
+            cl_event event;
+            cl_int err = clEnqueueUnmapMemObject(*my_queue, my_buffer.id(), my_ptr, wait_list.size(), wait_list.data(), &event);
+            CLPP_CHECK_ERROR(err);
+            my_ptr = NULL;
+            my_count = 0;
+            return Event(event);
+        }
+
+        /// Get the event of the map command.
+        const Event& event() const
+        {
+            return my_event;
+        }
+
+        /// Wait until the region is mapped.
+        void wait()
+        {
+            my_event.wait();
+        }
+
+        /// Get the buffer object this range belongs to.
+        const Buffer<T>& buffer() const
+        {
+            return my_buffer;
+        }
+
+        /// Get the pointer to the first mapped element.
+        T* data() const
+        {
+            return my_ptr;
+        }
+
+        /// Get the number of mapped elements.
+        size_t size() const
+        {
+            return my_count;
+        }
+
+        /// Check if the range is empty.
+        bool empty() const
+        {
+            return my_count == 0;
+        }
+
+        /// Get the iterator to the first mapped element.
+        Iterator begin() const
+        {
+            return my_ptr;
+        }
+
+        /// Get the iterator past the last mapped element.
+        Iterator end() const
+        {
+            return my_ptr + my_count;
+        }
+
+        /// Access a mapped element.
+        T& operator[](size_t i) const
+        {
+            return my_ptr[i];
+        }
+
+        /// Swap the content with another mapped range.
+        void swap(MappedRange& r) throw()
+        {
+            my_queue.swap(r.my_queue);
+            my_buffer.swap(r.my_buffer);
+            std::swap(my_ptr, r.my_ptr);
+            std::swap(my_count, r.my_count);
+            my_event.swap(r.my_event);
+        }
+
+    private:
+        MappedRange(const MappedRange&);
+        MappedRange& operator=(const MappedRange&);
+
+        Resource<cl_command_queue> my_queue;
+        Buffer<T> my_buffer;
+        T* my_ptr;
+        size_t my_count;
+        Event my_event;
+}; // template <typename T> class MappedRange
+
+} // namespace clpp
+
+#endif // CLPP_MAPPED_HPP
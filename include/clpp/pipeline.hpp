@@ -0,0 +1,211 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_PIPELINE_HPP
+#define CLPP_PIPELINE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "context.hpp"
+#include "commandqueue.hpp"
+#include "buffer.hpp"
+#include "kernel.hpp"
+#include "event.hpp"
+#include "error.hpp"
+
+namespace clpp {
+
+/// A double-buffered streaming pipeline.
+/** A stream pipeline processes a host array which may be larger than the
+    device memory. The array is split into chunks, and a small ring of
+    device buffers is rotated over them. Uploads, kernel executions and
+    downloads are enqueued on three separate command queues and ordered by
+    events only, so the upload of chunk N+1, the computation of chunk N and
+    the download of chunk N-1 can overlap.
+
+    The kernel must process \a count elements from an input buffer into an
+    output buffer of the same length, e.g.
+
+    \code
+    StreamPipeline<cl_float> pipeline(context, k, 1 << 20);
+    pipeline.run(input, output, n,
+        [](Kernel& k, const Buffer<cl_float>& in, const Buffer<cl_float>& out, size_t count){
+            k.setArgs(in, out, cl_uint(count));
+            return count; // the global size
+        });
+    \endcode
+
+    \tparam In      The element type of the input array.
+    \tparam Out     The element type of the output array.
+ */
+template <typename In, typename Out = In> class StreamPipeline {
+    public:
+        /// Results of a pipeline run.
+        struct Statistics {
+            /// Number of processed chunks.
+            size_t chunks;
+            /// Number of bytes uploaded and downloaded.
+            cl_ulong bytes;
+            /// Host wall time of the run in seconds.
+            double seconds;
+            /// Transferred bytes per second.
+            double throughput;
+            /// Total device time in nanoseconds spent in uploads.
+            cl_ulong upload_time;
+            /// Total device time in nanoseconds spent in the kernel.
+            cl_ulong compute_time;
+            /// Total device time in nanoseconds spent in downloads.
+            cl_ulong download_time;
+            /// Device time in nanoseconds from the first start to the last end.
+            cl_ulong span_time;
+            /// The sum of busy times of all stages divided by span_time. It is
+            /// 1 if nothing overlaps, and up to 3 if all stages fully overlap.
+            double overlap;
+        };
+
+        /// The function which binds kernel arguments for a chunk.
+        /** It takes the kernel, the input and output buffers of the chunk,
+            and the number of elements in the chunk, and returns the global
+            size used to execute the kernel.
+         */
+        typedef std::function<size_t(Kernel&, const Buffer<In>&, const Buffer<Out>&, size_t)> Binder;
+
+        /// Construct a stream pipeline.
+        /**
+            \param context      The context where the pipeline runs.
+            \param kernel       The kernel executed on every chunk.
+            \param chunk_size   Number of elements in a chunk. The buffers
+                                of a chunk must not exceed
+                                Device::getMaxMemAllocSize().
+            \param depth        Number of buffer pairs rotated over chunks.
+                                It should be 2 or 3.
+            \param device       The number of the device in \a context.
+         */
+        StreamPipeline(Context& context, const Kernel& kernel, size_t chunk_size, size_t depth = 2, size_t device = 0)
+            : my_kernel(kernel), my_chunk_size(chunk_size),
+              my_upload(createQueue(context, device)),
+              my_compute(createQueue(context, device)),
+              my_download(createQueue(context, device))
+        {
+            depth = std::max<size_t>(depth, 1);
+            for(size_t i = 0; i < depth; ++i){
+                my_inputs.push_back(context.createBuffer<In>(chunk_size, CL_MEM_READ_ONLY));
+                my_outputs.push_back(context.createBuffer<Out>(chunk_size, CL_MEM_WRITE_ONLY));
+            }
+        }
+
+        /// Get the number of elements in a chunk.
+        size_t chunkSize() const
+        {
+            return my_chunk_size;
+        }
+
+        /// Process a host array.
+        /** This function returns after all results have been written to
+            \a output.
+
+            \param input        The host array to be processed.
+            \param output       The host array receiving the results.
+            \param count        Number of elements in \a input and \a output.
+            \param bind         The function binding kernel arguments for
+                                each chunk.
+            \param local_size   The number of work-items in a work-group. If
+                                it is 0, an appropriate number is determined
+                                by the OpenCL implementation.
+
+            \return             Throughput and overlap achieved by this run.
+         */
+        Statistics run(const In* input, Out* output, size_t count, const Binder& bind, size_t local_size = 0)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            size_t depth = my_inputs.size();
+            size_t chunks = (count + my_chunk_size - 1) / my_chunk_size;
+            std::vector<Event> uploads(chunks), computes(chunks), downloads(chunks);
+
+            for(size_t i = 0; i < chunks; ++i){
+                size_t s = i % depth;
+                size_t offset = i * my_chunk_size;
+                size_t n = std::min(my_chunk_size, count - offset);
+
+                // The buffers of this slot are free again once the chunk
+                // which used them before has been computed and downloaded.
+                EventList upload_wait, compute_wait;
+                if(i >= depth){
+                    upload_wait.append(computes[i-depth]);
+                    compute_wait.append(downloads[i-depth]);
+                }
+
+                uploads[i] = my_upload.copy(input + offset, my_inputs[s], 0, n, CL_FALSE, upload_wait);
+                compute_wait.append(uploads[i]);
+
+                size_t global_size = bind(my_kernel, my_inputs[s], my_outputs[s], n);
+                computes[i] = my_compute.exec(my_kernel, global_size, local_size, compute_wait);
+                downloads[i] = my_download.copy(my_outputs[s], 0, n, output + offset, CL_FALSE, EventList(computes[i]));
+
+                my_upload.flush();
+                my_compute.flush();
+                my_download.flush();
+            }
+
+            my_upload.finish();
+            my_compute.finish();
+            my_download.finish();
+
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            Statistics s;
+            s.chunks = chunks;
+            s.bytes = static_cast<cl_ulong>(count) * (sizeof(In) + sizeof(Out));
+            s.seconds = elapsed.count();
+            s.throughput = s.seconds > 0 ? s.bytes / s.seconds : 0;
+            s.upload_time = busyTime(uploads);
+            s.compute_time = busyTime(computes);
+            s.download_time = busyTime(downloads);
+            s.span_time = 0;
+            s.overlap = 0;
+            if(chunks > 0){
+                cl_ulong first = std::min(uploads[0].getStartTime(), computes[0].getStartTime());
+                cl_ulong last = downloads[chunks-1].getEndTime();
+                s.span_time = last > first ? last - first : 0;
+                if(s.span_time > 0)
+                    s.overlap = double(s.upload_time + s.compute_time + s.download_time) / s.span_time;
+            }
+            return s;
+        }
+
+    private:
+        static CommandQueue createQueue(Context& context, size_t device)
+        {
+            cl_int err;
+            const Device& d = context.devices()[device];
+            cl_command_queue q = clCreateCommandQueue(context.id(), d.id(), CL_QUEUE_PROFILING_ENABLE, &err);
+            CLPP_CHECK_ERROR(err);
+            return CommandQueue(q, d);
+        }
+
+        static cl_ulong busyTime(const std::vector<Event>& events)
+        {
+            cl_ulong total = 0;
+            for(size_t i = 0; i < events.size(); ++i)
+                total += events[i].getExecutionTime();
+            return total;
+        }
+
+        Kernel my_kernel;
+        size_t my_chunk_size;
+        CommandQueue my_upload;
+        CommandQueue my_compute;
+        CommandQueue my_download;
+        std::vector< Buffer<In> > my_inputs;
+        std::vector< Buffer<Out> > my_outputs;
+}; // template <typename In, typename Out> class StreamPipeline
+
+} // namespace clpp
+
+#endif // CLPP_PIPELINE_HPP
@@ -12,6 +12,7 @@
 
 #include "common.hpp"
 #include "error.hpp"
+#include "resource.hpp"
 #include "device.hpp"
 
 namespace clpp {
@@ -185,6 +186,7 @@ class DeviceList {
             my_list.resize(num);
             err = clGetDeviceIDs(platform.id(), type, num, &my_list[0], NULL);
             CLPP_CHECK_ERROR(err);
+            my_devices.assign(my_list.begin(), my_list.end());
         }
 
         /// Construct an empty device list.
@@ -194,15 +196,17 @@ class DeviceList {
         /**
             \param d    The device which is contained in this list.
          */
-        DeviceList(Device d) : my_list(1, d.id()) {}
+        DeviceList(Device d) : my_list(1, d.id()), my_devices(1, d) {}
 
         /// Append a device to this device list.
-        /**
+        /** A sub-device is kept alive by the copy of \a d stored in this list.
+
             \param d    The device to be appended.
          */
         void append(Device d)
         {
             my_list.push_back(d.id());
+            my_devices.push_back(d);
         }
 
         /// Check if these devices are associated with the same platform.
@@ -237,13 +241,15 @@ class DeviceList {
         }
 
         /// Get the specific device in this list.
-        /**
+        /** The device information cached by the returned object is kept
+            by this list.
+
             \param i    The number of the specified device.
             \return     The \a i 'th device in this list.
          */
-        Device operator[](size_t i) const
+        const Device& operator[](size_t i) const
         {
-            return Device(my_list[i]);
+            return my_devices[i];
         }
 
         /// Get the raw pointer to cl_device_id in this list.
@@ -259,8 +265,37 @@ class DeviceList {
 
     private:
         std::vector<cl_device_id> my_list;
+        std::vector<Device> my_devices;
 }; // class DeviceList
 
+#ifdef CL_VERSION_1_2
+inline DeviceList Device::partition(const Partition& p) const
+{
+    cl_uint num = 0;
+    cl_int err = clCreateSubDevices(my_id, p.properties(), 0, NULL, &num);
+    CLPP_CHECK_ERROR(err);
+
+    DeviceList result;
+    if(num == 0)
+        return result;
+
+    std::vector<cl_device_id> ids(num);
+    err = clCreateSubDevices(my_id, p.properties(), num, &ids[0], NULL);
+    CLPP_CHECK_ERROR(err);
+
+    // Take over the reference to each sub-device.
+    std::vector< std::shared_ptr< Resource<cl_device_id> > > owners(num);
+    for(cl_uint i = 0; i < num; ++i)
+        owners[i] = std::make_shared< Resource<cl_device_id> >(ids[i]);
+    for(cl_uint i = 0; i < num; ++i){
+        Device d(ids[i]);
+        d.my_owner = owners[i];
+        result.append(d);
+    }
+    return result;
+}
+#endif
+
 } // namespace clpp
 
 #endif // CLPP_PLATFORM_HPP
@@ -0,0 +1,339 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_POOL_HPP
+#define CLPP_POOL_HPP
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "common.hpp"
+#include "error.hpp"
+#include "resource.hpp"
+
+namespace clpp {
+
+/// A pool of recycled buffer memory objects.
+/** The pool keeps released \c cl_mem objects grouped by size class and memory
+    flags, so that a later allocation of a similar buffer can reuse them
+    instead of calling \c clCreateBuffer again. Size classes are powers of
+    two, starting from BufferPool::MIN_CLASS_SIZE bytes.
+
+    Please use Context::enableBufferPool instead of creating this object
+    directly. Buffers obtained from the pool are returned to it when the last
+    Buffer object referring to them is destroyed.
+
+    Commands enqueued before a buffer is destroyed may still use its memory,
+    so a returned memory object is not reused at once. A marker is enqueued
+    on every command queue given to the pool, and the memory object is only
+    handed out again when all those markers are complete. Commands on other
+    command queues must be finished before a pooled buffer is destroyed.
+
+    All member functions are thread-safe.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+    public:
+        /// The smallest size class in bytes.
+        static const size_t MIN_CLASS_SIZE = 256;
+
+        /// Usage counters of a buffer pool.
+        struct Statistics {
+            /// Number of allocations served by a pooled memory object.
+            size_t hits;
+            /// Number of allocations which had to call \c clCreateBuffer.
+            size_t misses;
+            /// Number of bytes held by idle memory objects in the pool,
+            /// including those which may still be used by commands.
+            size_t pooled_bytes;
+            /// Number of idle memory objects in the pool, including those
+            /// which may still be used by commands.
+            size_t pooled_buffers;
+        };
+
+        /// Construct a buffer pool.
+        /**
+            \param context          The context where buffers are allocated.
+            \param max_pooled_bytes The maximum number of bytes kept by idle
+                                    memory objects. Memory objects returned
+                                    beyond this limit are released.
+            \param queues           The command queues where buffers of the
+                                    pool are used.
+         */
+        BufferPool(cl_context context, size_t max_pooled_bytes, const std::vector<cl_command_queue>& queues = std::vector<cl_command_queue>())
+            : my_max_pooled_bytes(max_pooled_bytes)
+        {
+            CLPP_CHECK_ERROR(clRetainContext(context));
+            my_context.reset(context);
+            for(size_t i = 0; i < queues.size(); ++i){
+                CLPP_CHECK_ERROR(clRetainCommandQueue(queues[i]));
+                my_queues.push_back(Resource<cl_command_queue>(queues[i]));
+            }
+            my_statistics.hits = 0;
+            my_statistics.misses = 0;
+            my_statistics.pooled_bytes = 0;
+            my_statistics.pooled_buffers = 0;
+        }
+
+        ~BufferPool() throw()
+        {
+            releaseAll();
+        }
+
+        /// Get the size class of an allocation.
+        /**
+            \param bytes    The requested size in bytes.
+            \return         The smallest size class which can hold \a bytes.
+         */
+        static size_t sizeClass(size_t bytes)
+        {
+            size_t c = MIN_CLASS_SIZE;
+            while(c < bytes)
+                c <<= 1;
+            return c;
+        }
+
+        /// Check if an allocation can be served by the pool.
+        /** Buffers which are backed by application memory can't be recycled.
+
+            \param flags    The memory flags of the allocation.
+            \param ptr      The host pointer of the allocation.
+         */
+        static bool poolable(cl_mem_flags flags, const void* ptr)
+        {
+            return ptr == NULL && (flags & (CL_MEM_USE_HOST_PTR | CL_MEM_COPY_HOST_PTR)) == 0;
+        }
+
+        /// Acquire a memory object from the pool.
+        /**
+            \param bytes    The requested size in bytes.
+            \param flags    The memory flags of the allocation.
+            \param mem      Receives the memory object. The caller owns one
+                            reference of it.
+
+            \return         The lease of \a mem. The memory object is returned
+                            to the pool when the lease is destroyed.
+         */
+        std::shared_ptr<void> acquire(size_t bytes, cl_mem_flags flags, cl_mem& mem)
+        {
+            // Fail like clCreateBuffer instead of rounding up to a size
+            // class.
+            if(bytes == 0)
+                CLPP_CHECK_ERROR(CL_INVALID_BUFFER_SIZE);
+
+            Key key(sizeClass(bytes), flags);
+            mem = 0;
+            {
+                std::lock_guard<std::mutex> lock(my_mutex);
+                FreeList& list = my_free_lists[key];
+                collect(list);
+                if(!list.empty()){
+                    mem = list.back().mem;
+                    list.pop_back();
+                    my_statistics.pooled_bytes -= key.first;
+                    my_statistics.pooled_buffers -= 1;
+                    my_statistics.hits += 1;
+                }else{
+                    my_statistics.misses += 1;
+                }
+            }
+
+            if(mem == 0){
+                cl_int err = 0;
+                mem = clCreateBuffer(*my_context, flags, key.first, NULL, &err);
+                CLPP_CHECK_ERROR(err);
+            }
+
+            std::shared_ptr<void> lease(new Lease(shared_from_this(), mem, key));
+            CLPP_CHECK_ERROR(clRetainMemObject(mem));
+            return lease;
+        }
+
+        /// Release all idle memory objects in the pool.
+        void trim()
+        {
+            releaseAll();
+        }
+
+        /// Get the usage counters of this pool.
+        Statistics statistics() const
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            return my_statistics;
+        }
+
+    private:
+        typedef std::pair<size_t, cl_mem_flags> Key;
+
+        // A returned memory object, and the markers which complete when the
+        // commands enqueued before it was returned are complete.
+        struct Entry {
+            cl_mem mem;
+            std::vector<cl_event> markers;
+        };
+
+        // Entries which are ready to be reused come first; entries from
+        // index "ready" on still wait for their markers.
+        struct FreeList {
+            FreeList() : ready(0) {}
+
+            bool empty() const
+            {
+                return ready == 0;
+            }
+
+            Entry& back()
+            {
+                return entries[ready - 1];
+            }
+
+            void pop_back()
+            {
+                entries.erase(entries.begin() + --ready);
+            }
+
+            std::vector<Entry> entries;
+            size_t ready;
+        };
+
+        // Holds the pool's reference to a memory object while it is in use.
+        class Lease {
+            public:
+                Lease(const std::shared_ptr<BufferPool>& pool, cl_mem mem, Key key)
+                    : my_pool(pool), my_mem(mem), my_key(key)
+                {}
+
+                ~Lease() throw()
+                {
+                    my_pool->recycle(my_mem, my_key);
+                }
+
+            private:
+                Lease(const Lease&);
+                Lease& operator=(const Lease&);
+
+                std::shared_ptr<BufferPool> my_pool;
+                cl_mem my_mem;
+                Key my_key;
+        }; // class BufferPool::Lease
+
+        // The markers are enqueued without the lock, so that returning a
+        // buffer never blocks acquire() on other threads behind OpenCL
+        // calls. The lock is only held to check the limit and push.
+        void recycle(cl_mem mem, Key key) throw()
+        {
+            if(!fits(key.first)){
+                clReleaseMemObject(mem);
+                return;
+            }
+
+            Entry e;
+            e.mem = mem;
+            try{
+                mark(e);
+                std::lock_guard<std::mutex> lock(my_mutex);
+                // The limit is checked again, since other buffers may have
+                // been returned meanwhile.
+                if(my_statistics.pooled_bytes + key.first <= my_max_pooled_bytes){
+                    my_free_lists[key].entries.push_back(e);
+                    my_statistics.pooled_bytes += key.first;
+                    my_statistics.pooled_buffers += 1;
+                    return;
+                }
+            }catch(...){
+            }
+            releaseEntry(e);
+        }
+
+        bool fits(size_t bytes) const
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            return my_statistics.pooled_bytes + bytes <= my_max_pooled_bytes;
+        }
+
+        // Enqueue a marker after the commands which may use e.mem on each
+        // command queue. If a marker can't be enqueued, the queue is
+        // finished instead.
+        void mark(Entry& e)
+        {
+            e.markers.reserve(my_queues.size());
+            for(size_t i = 0; i < my_queues.size(); ++i){
+                cl_command_queue q = *my_queues[i];
+                cl_event marker;
+#ifdef CL_VERSION_1_2
+                cl_int err = clEnqueueMarkerWithWaitList(q, 0, NULL, &marker);
+#else
+                cl_int err = clEnqueueMarker(q, &marker);
+#endif
+                if(err == CL_SUCCESS){
+                    e.markers.push_back(marker);
+                    clFlush(q);
+                }else{
+                    clFinish(q);
+                }
+            }
+        }
+
+        // Move the entries whose markers are complete to the ready part of
+        // a free list.
+        static void collect(FreeList& list)
+        {
+            for(size_t i = list.ready; i < list.entries.size(); ++i){
+                Entry& e = list.entries[i];
+                while(!e.markers.empty()){
+                    cl_int status;
+                    cl_int err = clGetEventInfo(e.markers.back(), CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status, NULL);
+                    // A negative status means the commands were terminated,
+                    // so they don't use the memory any more either.
+                    if(err == CL_SUCCESS && status > CL_COMPLETE)
+                        break;
+                    clReleaseEvent(e.markers.back());
+                    e.markers.pop_back();
+                }
+                if(e.markers.empty())
+                    std::swap(list.entries[list.ready++], e);
+            }
+        }
+
+        static void releaseEntry(Entry& e) throw()
+        {
+            for(size_t i = 0; i < e.markers.size(); ++i)
+                clReleaseEvent(e.markers[i]);
+            clReleaseMemObject(e.mem);
+        }
+
+        void releaseAll() throw()
+        {
+            std::map<Key, FreeList> lists;
+            {
+                std::lock_guard<std::mutex> lock(my_mutex);
+                lists.swap(my_free_lists);
+                my_statistics.pooled_bytes = 0;
+                my_statistics.pooled_buffers = 0;
+            }
+            std::map<Key, FreeList>::iterator i;
+            // Memory objects still used by commands are deleted by OpenCL
+            // when the commands are complete.
+            for(i = lists.begin(); i != lists.end(); ++i)
+                for(size_t j = 0; j < i->second.entries.size(); ++j)
+                    releaseEntry(i->second.entries[j]);
+        }
+
+        BufferPool(const BufferPool&);
+        BufferPool& operator=(const BufferPool&);
+
+        Resource<cl_context> my_context;
+        std::vector< Resource<cl_command_queue> > my_queues;
+        size_t my_max_pooled_bytes;
+        mutable std::mutex my_mutex;
+        std::map<Key, FreeList> my_free_lists;
+        Statistics my_statistics;
+}; // class BufferPool
+
+} // namespace clpp
+
+#endif // CLPP_POOL_HPP
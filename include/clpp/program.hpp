@@ -6,7 +6,12 @@
 #ifndef CLPP_PROGRAM_HPP
 #define CLPP_PROGRAM_HPP
 
+#include <atomic>
 #include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include "resource.hpp"
@@ -18,6 +23,10 @@ namespace clpp {
 /// The program object.
 /** A program consists of a set of kernels. Programs may also contain
     auxiliary functions called by the \c kernel functions and constant data.
+
+    A program object keeps the kernel objects released by the application,
+    so that kernel() can hand them out again instead of creating new ones.
+    The cache is shared by copies of the program object.
  */
 class Program {
     public:
@@ -26,7 +35,11 @@ class Program {
             Context::readProgramSource or Context::readProgramSourceFile
             to create a program object.
          */
-        Program(cl_program p = 0) : my_resource(p) {}
+        Program(cl_program p = 0) : my_resource(p)
+        {
+            if(p != 0)
+                my_kernels.reset(new KernelCache);
+        }
 
         /// Get the \c cl_program object created by OpenCL API.
         /**
@@ -100,7 +113,46 @@ class Program {
 
 			CLPP_CHECK_ERROR(err);
 		}
-    
+
+        /// Build the program on specified devices without blocking.
+        /** The build is started with a notification callback, so the
+            calling thread does not wait for the compiler, e.g.
+
+            \code
+            std::future<Program> f = program.buildAsync(context.devices());
+            // ... do other work ...
+            Kernel k = f.get().kernel("main");
+            \endcode
+
+            The future receives this program when the build is complete, or
+            a BuildError if it fails on any device. Some OpenCL
+            implementations build synchronously even when a callback is
+            given, in which case the future is ready when this function
+            returns.
+
+            \param device_list The list of devices where the program is going
+                                to execute.
+            \param options     Additional compiler options for this program.
+
+            \return            The future of the built program.
+         */
+        std::future<Program> buildAsync(const DeviceList& device_list, const char* options = NULL);
+
+        /// Build the program on the specified device without blocking.
+        /**
+            \param device      The device where the program is going to
+                                execute.
+            \param options     Additional compiler options for this program.
+
+            \return            The future of the built program.
+
+            \sa buildAsync(const DeviceList&, const char*)
+         */
+        std::future<Program> buildAsync(Device device, const char* options = NULL)
+        {
+            return buildAsync(DeviceList(device), options);
+        }
+
         /// Get the build log.
         /** A string containing the log generated by the compiler.
          */
@@ -113,18 +165,92 @@ class Program {
             return buf;
         }
 
-        /// Get the kernel object in this program.
-        /**
+        /// Get a kernel object in this program.
+        /** Every call returns an independent kernel object, with its own
+            arguments, which can be used by one thread while other threads
+            use other instances of the same kernel function. When the
+            returned object and all its copies are destroyed, the kernel is
+            returned to the cache of this program, and a later call with the
+            same name hands it out again instead of calling
+            \c clCreateKernel. A kernel handed out again keeps the arguments
+            set by its previous user, so all arguments should be set before
+            it is launched.
+
+            This function is thread-safe.
+
             \param kernel_name  The name of the kernel function.
             \return             The kernel object corresponding to the kernl
                                 function.
          */
         Kernel kernel(const char* kernel_name)
+        {
+            if(my_kernels){
+                std::lock_guard<std::mutex> lock(my_kernels->mutex);
+                std::map<std::string, std::vector<Kernel> >::iterator i = my_kernels->idle.find(kernel_name);
+                if(i != my_kernels->idle.end() && !i->second.empty()){
+                    Kernel k = i->second.back();
+                    i->second.pop_back();
+                    return checkOut(kernel_name, k);
+                }
+            }
+            return checkOut(kernel_name, createKernel(kernel_name));
+        }
+
+        /// Create an independent kernel object.
+        /** Unlike kernel(), this function always creates a new kernel
+            object, which is not returned to the cache when it is released.
+
+            \param kernel_name  The name of the kernel function.
+            \return             The new kernel object.
+         */
+        Kernel createKernel(const char* kernel_name)
         {
             cl_int err = 0;
             cl_kernel k = clCreateKernel(id(), kernel_name, &err);
             CLPP_CHECK_ERROR(err);
-            return Kernel(k);
+            return Kernel(k, kernel_name);
+        }
+
+        /// Get kernel objects of all kernel functions in this program.
+        /** The kernel objects are created at once by
+            \c clCreateKernelsInProgram. Like the objects returned by
+            kernel(), they are returned to the cache when they are released,
+            so calling this function and discarding the result warms up the
+            cache with one instance of every kernel function.
+
+            \return     The kernel objects, in the order given by OpenCL.
+         */
+        std::vector<Kernel> kernels()
+        {
+            cl_uint num = 0;
+            cl_int err = clCreateKernelsInProgram(id(), 0, NULL, &num);
+            CLPP_CHECK_ERROR(err);
+            std::vector<cl_kernel> ids(num);
+            if(num > 0){
+                err = clCreateKernelsInProgram(id(), num, &ids[0], NULL);
+                CLPP_CHECK_ERROR(err);
+            }
+
+            // Take ownership of all kernels before anything can throw.
+            std::vector<Kernel> result;
+            result.reserve(num);
+            for(cl_uint i = 0; i < num; ++i)
+                result.push_back(Kernel(ids[i]));
+            for(cl_uint i = 0; i < num; ++i)
+                result[i] = checkOut(result[i].name(), result[i]);
+            return result;
+        }
+
+        /// Release the cached kernel objects.
+        /** Kernel objects which are still used elsewhere stay valid, and
+            are returned to the cache when they are released.
+         */
+        void clearKernelCache()
+        {
+            if(my_kernels){
+                std::lock_guard<std::mutex> lock(my_kernels->mutex);
+                my_kernels->idle.clear();
+            }
         }
 
         /// Swap the pointed content with another program object.
@@ -134,6 +260,7 @@ class Program {
         void swap(Program& p) throw()
         {
             my_resource.swap(p.my_resource);
+            my_kernels.swap(p.my_kernels);
         }
 
 		/// The exception object for build errors.
@@ -167,9 +294,155 @@ class Program {
 		}; // class Program::BuildError
 
     private:
+        struct AsyncBuild;
+        static void CL_CALLBACK onBuilt(cl_program, void* user_data);
+        struct AsyncBuildRegistry;
+
+        // The kernel objects which are not used by the application, by
+        // their names.
+        struct KernelCache {
+            std::mutex mutex;
+            std::map<std::string, std::vector<Kernel> > idle;
+        };
+
+        // Returns a kernel to the cache when it is released, unless the
+        // program has been destroyed.
+        class KernelLease {
+            public:
+                KernelLease(const std::shared_ptr<KernelCache>& cache, const std::string& name, const Kernel& k)
+                    : my_cache(cache), my_name(name), my_kernel(k)
+                {}
+
+                ~KernelLease() throw()
+                {
+                    std::shared_ptr<KernelCache> cache = my_cache.lock();
+                    if(!cache)
+                        return;
+                    try{
+                        std::lock_guard<std::mutex> lock(cache->mutex);
+                        cache->idle[my_name].push_back(my_kernel);
+                    }catch(...){
+                        // The kernel is released instead.
+                    }
+                }
+
+            private:
+                KernelLease(const KernelLease&);
+                KernelLease& operator=(const KernelLease&);
+
+                std::weak_ptr<KernelCache> my_cache;
+                std::string my_name;
+                Kernel my_kernel;
+        }; // class Program::KernelLease
+
+        Kernel checkOut(const std::string& name, const Kernel& k)
+        {
+            if(!my_kernels)
+                return k;
+            std::shared_ptr<void> lease(new KernelLease(my_kernels, name, k));
+            return Kernel(k, lease);
+        }
+
         Resource<cl_program> my_resource;
+        std::shared_ptr<KernelCache> my_kernels;
 }; // class Program
 
+// The state of a build started by buildAsync. The promise is
+// fulfilled once, by either the callback or buildAsync itself.
+struct Program::AsyncBuild {
+    AsyncBuild(const Program& p, const DeviceList& d)
+        : program(p), devices(d), done(false)
+    {}
+
+    void finish(cl_int err)
+    {
+        if(done.exchange(true))
+            return;
+
+        try{
+            if(err == CL_SUCCESS || err == CL_BUILD_PROGRAM_FAILURE)
+                for(size_t i = 0; i < devices.size(); ++i)
+                    if(program.status(devices[i]) == CL_BUILD_ERROR)
+                        throw BuildError(CL_BUILD_PROGRAM_FAILURE, __FILE__, __FUNCTION__, __LINE__, program.getBuildLog(devices[i]));
+            CLPP_CHECK_ERROR(err);
+            promise.set_value(program);
+        }catch(...){
+            promise.set_exception(std::current_exception());
+        }
+    }
+
+    Program program;
+    DeviceList devices;
+    std::atomic<bool> done;
+    std::promise<Program> promise;
+};
+
+// Builds waiting for their callback are kept in a registry, by a token
+// which is passed to the callback instead of a pointer. Tokens are never
+// reused, so a callback for a build which is already finished finds
+// nothing, and nothing is leaked if the callback is never called.
+struct Program::AsyncBuildRegistry {
+    static void* add(const std::shared_ptr<AsyncBuild>& build)
+    {
+        AsyncBuildRegistry& r = instance();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        size_t token = ++r.next;
+        r.builds[token] = build;
+        return reinterpret_cast<void*>(token);
+    }
+
+    // Remove a build and return it, or return null if it was removed.
+    static std::shared_ptr<AsyncBuild> take(void* token)
+    {
+        AsyncBuildRegistry& r = instance();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        std::shared_ptr<AsyncBuild> build;
+        std::map< size_t, std::shared_ptr<AsyncBuild> >::iterator i = r.builds.find(reinterpret_cast<size_t>(token));
+        if(i != r.builds.end()){
+            build.swap(i->second);
+            r.builds.erase(i);
+        }
+        return build;
+    }
+
+    static AsyncBuildRegistry& instance()
+    {
+        static AsyncBuildRegistry registry;
+        return registry;
+    }
+
+    AsyncBuildRegistry() : next(0) {}
+
+    std::mutex mutex;
+    size_t next;
+    std::map< size_t, std::shared_ptr<AsyncBuild> > builds;
+};
+
+inline void CL_CALLBACK Program::onBuilt(cl_program, void* user_data)
+{
+    std::shared_ptr<AsyncBuild> build = AsyncBuildRegistry::take(user_data);
+    if(build)
+        build->finish(CL_SUCCESS);
+}
+
+inline std::future<Program> Program::buildAsync(const DeviceList& device_list, const char* options)
+{
+    std::shared_ptr<AsyncBuild> state(new AsyncBuild(*this, device_list));
+    std::future<Program> result = state->promise.get_future();
+
+    // The registry keeps the build until the callback, which may run
+    // after this function returns.
+    void* token = AsyncBuildRegistry::add(state);
+    cl_int err = clBuildProgram(id(), device_list.size(), device_list.data(), options, &onBuilt, token);
+    if(err != CL_SUCCESS){
+        // The callback is not called for invalid arguments, and a failed
+        // build may or may not notify, so the build is removed here.
+        AsyncBuildRegistry::take(token);
+        state->finish(err);
+    }
+    return result;
+}
+
 } // namespace clpp
 
 #endif // CLPP_PROGRAM_HPP
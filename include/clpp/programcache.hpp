@@ -0,0 +1,348 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_PROGRAMCACHE_HPP
+#define CLPP_PROGRAMCACHE_HPP
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "common.hpp"
+#include "error.hpp"
+#include "platform.hpp"
+#include "program.hpp"
+
+namespace clpp {
+
+/// Compute the 64-bit FNV-1a hash of a chunk of memory.
+/**
+    \param data     The data to be hashed.
+    \param len      Number of bytes in \a data.
+    \param h        The initial hash value. It can be the hash of previous
+                    chunks to hash data incrementally.
+
+    \return         The hash value.
+ */
+inline cl_ulong Fnv1a64(const void* data, size_t len, cl_ulong h = 14695981039346656037ULL)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for(size_t i = 0; i < len; ++i){
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/// A persistent cache of program binaries.
+/** The cache stores \c CL_PROGRAM_BINARIES of built programs in a directory
+    and reloads them by \c clCreateProgramWithBinary, so that a program
+    doesn't have to be compiled from source again when the process restarts.
+
+    Cache entries are keyed by a hash of the source, the build options, and
+    the name, driver version and platform version of every device. Entries
+    which can't be loaded or built, e.g. after a driver update or when the
+    file is corrupted, are rebuilt from source and replaced.
+
+    Please use Context::enableProgramCache instead of using this class
+    directly. All member functions are thread-safe.
+ */
+class ProgramCache {
+    public:
+        /// Usage counters of a program cache.
+        struct Statistics {
+            /// Number of programs loaded from the cache.
+            size_t hits;
+            /// Number of programs built from source.
+            size_t misses;
+            /// Number of cache entries which were found but couldn't be used.
+            size_t stale;
+            /// Total time in nanoseconds spent building programs from source.
+            cl_ulong compile_time;
+            /// Total time in nanoseconds spent loading programs from the cache.
+            cl_ulong load_time;
+        };
+
+        /// Construct a program cache.
+        /**
+            \param directory    The directory where cache entries are stored.
+                                It must exist and be writable.
+         */
+        explicit ProgramCache(const std::string& directory)
+            : my_directory(directory)
+        {
+            my_statistics.hits = 0;
+            my_statistics.misses = 0;
+            my_statistics.stale = 0;
+            my_statistics.compile_time = 0;
+            my_statistics.load_time = 0;
+        }
+
+        /// Get the cache directory.
+        const std::string& directory() const
+        {
+            return my_directory;
+        }
+
+        /// Create and build a program, using the cached binaries if possible.
+        /**
+            \param context  The context where the program is created.
+            \param devices  The devices where the program is built.
+            \param source   The program source code. It must be
+                            null-terminated.
+            \param options  Additional compiler options for this program.
+
+            \return         The built program object.
+         */
+        Program build(cl_context context, const DeviceList& devices, const char* source, const char* options = NULL)
+        {
+            return build(context, devices, source, Fnv1a64(source, std::strlen(source)), options);
+        }
+
+        /// Create and build a program, using the cached binaries if possible.
+        /** This version takes a precomputed hash of the source.
+
+            \param context      The context where the program is created.
+            \param devices      The devices where the program is built.
+            \param source       The program source code. It must be
+                                null-terminated.
+            \param source_hash  The value of Fnv1a64() over \a source.
+            \param options      Additional compiler options for this program.
+
+            \return             The built program object.
+         */
+        Program build(cl_context context, const DeviceList& devices, const char* source, cl_ulong source_hash, const char* options)
+        {
+            std::string key = makeKey(devices, source_hash, options);
+            std::string path = entryPath(key);
+
+            Clock::time_point start = Clock::now();
+            bool found = false;
+            Program p = load(context, devices, key, path, options, found);
+            if(p.id() != 0){
+                record(&Statistics::hits, &Statistics::load_time, start);
+                return p;
+            }
+            if(found){
+                std::lock_guard<std::mutex> lock(my_mutex);
+                my_statistics.stale += 1;
+            }
+
+            start = Clock::now();
+            cl_int err;
+            cl_program pid = clCreateProgramWithSource(context, 1, &source, NULL, &err);
+            CLPP_CHECK_ERROR(err);
+            p = Program(pid);
+            p.build(devices, options);
+            record(&Statistics::misses, &Statistics::compile_time, start);
+
+            store(p, devices, key, path);
+            return p;
+        }
+
+        /// Get the usage counters of this cache.
+        Statistics statistics() const
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            return my_statistics;
+        }
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        static std::string hex(cl_ulong v)
+        {
+            char buf[17];
+            std::sprintf(buf, "%016llx", static_cast<unsigned long long>(v));
+            return buf;
+        }
+
+        static std::string makeKey(const DeviceList& devices, cl_ulong source_hash, const char* options)
+        {
+            std::ostringstream key;
+            key << "source=" << hex(source_hash) << '\n';
+            key << "options=" << (options ? options : "") << '\n';
+            // The device information is cached by the device list, so this
+            // doesn't call OpenCL after the first build.
+            for(size_t i = 0; i < devices.size(); ++i){
+                const Device& d = devices[i];
+                key << "device=" << d.name().c_str() << '|'
+                    << d.driverVersion().c_str() << '|'
+                    << d.version().c_str() << '\n';
+            }
+            return key.str();
+        }
+
+        std::string entryPath(const std::string& key) const
+        {
+            return my_directory + "/" + hex(Fnv1a64(key.data(), key.size())) + ".clbin";
+        }
+
+        void record(size_t Statistics::* counter, cl_ulong Statistics::* time, Clock::time_point start)
+        {
+            cl_ulong ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            std::lock_guard<std::mutex> lock(my_mutex);
+            my_statistics.*counter += 1;
+            my_statistics.*time += ns;
+        }
+
+        // Entry format: the key length and text, the number of binaries,
+        // then the size and content of each binary in device order.
+        static Program load(cl_context context, const DeviceList& devices, const std::string& key, const std::string& path,
+                            const char* options, bool& found)
+        {
+            std::ifstream fin(path.c_str(), std::ios::binary);
+            found = fin.is_open();
+            if(!found)
+                return Program();
+
+            cl_ulong len = 0;
+            fin.read(reinterpret_cast<char*>(&len), sizeof(len));
+            if(!fin || len != key.size())
+                return Program();
+            std::string stored(key.size(), 0);
+            fin.read(&stored[0], stored.size());
+            cl_ulong num = 0;
+            fin.read(reinterpret_cast<char*>(&num), sizeof(num));
+            if(!fin || stored != key || num != devices.size())
+                return Program();
+
+            std::vector< std::vector<unsigned char> > binaries(devices.size());
+            std::vector<size_t> sizes(devices.size());
+            std::vector<const unsigned char*> ptrs(devices.size());
+            for(size_t i = 0; i < devices.size(); ++i){
+                cl_ulong size = 0;
+                fin.read(reinterpret_cast<char*>(&size), sizeof(size));
+                if(!fin || size == 0 || size > (1ULL << 32))
+                    return Program();
+                binaries[i].resize(static_cast<size_t>(size));
+                fin.read(reinterpret_cast<char*>(&binaries[i][0]), binaries[i].size());
+                if(!fin)
+                    return Program();
+                sizes[i] = binaries[i].size();
+                ptrs[i] = &binaries[i][0];
+            }
+
+            cl_int err;
+            std::vector<cl_int> status(devices.size(), CL_SUCCESS);
+            cl_program pid = clCreateProgramWithBinary(context, devices.size(), devices.data(), &sizes[0], &ptrs[0], &status[0], &err);
+            if(err != CL_SUCCESS)
+                return Program();
+            Program p(pid);
+            for(size_t i = 0; i < status.size(); ++i)
+                if(status[i] != CL_SUCCESS)
+                    return Program();
+
+            // Binaries in an intermediate form are finalized by this build,
+            // so the options must be given again.
+            try{
+                p.build(devices, options);
+            }catch(const Error&){
+                return Program();
+            }
+            return p;
+        }
+
+        // Saving an entry is best-effort. Failures leave the cache unchanged.
+        static void store(Program& p, const DeviceList& devices, const std::string& key, const std::string& path)
+        {
+            cl_uint num = 0;
+            if(clGetProgramInfo(p.id(), CL_PROGRAM_NUM_DEVICES, sizeof(num), &num, NULL) != CL_SUCCESS || num == 0)
+                return;
+            std::vector<cl_device_id> ids(num);
+            std::vector<size_t> sizes(num);
+            if(clGetProgramInfo(p.id(), CL_PROGRAM_DEVICES, sizeof(cl_device_id)*num, &ids[0], NULL) != CL_SUCCESS)
+                return;
+            if(clGetProgramInfo(p.id(), CL_PROGRAM_BINARY_SIZES, sizeof(size_t)*num, &sizes[0], NULL) != CL_SUCCESS)
+                return;
+
+            std::vector< std::vector<unsigned char> > binaries(num);
+            std::vector<unsigned char*> ptrs(num);
+            for(cl_uint i = 0; i < num; ++i){
+                if(sizes[i] == 0)
+                    return;
+                binaries[i].resize(sizes[i]);
+                ptrs[i] = &binaries[i][0];
+            }
+            if(clGetProgramInfo(p.id(), CL_PROGRAM_BINARIES, sizeof(unsigned char*)*num, &ptrs[0], NULL) != CL_SUCCESS)
+                return;
+
+            // Write to a temporary file first so that other processes never
+            // see a partially written entry. The name is unique among the
+            // processes and threads storing the same entry.
+            std::ostringstream tmp;
+            tmp << path << '.' << processId() << '.' << nextTemporary() << ".tmp";
+            {
+                std::ofstream fout(tmp.str().c_str(), std::ios::binary);
+                cl_ulong len = key.size();
+                fout.write(reinterpret_cast<const char*>(&len), sizeof(len));
+                fout.write(key.data(), key.size());
+                cl_ulong count = devices.size();
+                fout.write(reinterpret_cast<const char*>(&count), sizeof(count));
+                for(size_t i = 0; i < devices.size(); ++i){
+                    size_t j = 0;
+                    while(j < num && ids[j] != devices[i].id())
+                        ++j;
+                    if(j == num){
+                        fout.close();
+                        std::remove(tmp.str().c_str());
+                        return;
+                    }
+                    cl_ulong size = sizes[j];
+                    fout.write(reinterpret_cast<const char*>(&size), sizeof(size));
+                    fout.write(reinterpret_cast<const char*>(&binaries[j][0]), sizes[j]);
+                }
+                if(!fout){
+                    fout.close();
+                    std::remove(tmp.str().c_str());
+                    return;
+                }
+            }
+            if(std::rename(tmp.str().c_str(), path.c_str()) != 0){
+                // Some systems don't replace an existing file by rename.
+                std::remove(path.c_str());
+                if(std::rename(tmp.str().c_str(), path.c_str()) != 0)
+                    std::remove(tmp.str().c_str());
+            }
+        }
+
+        static long processId()
+        {
+#ifdef _WIN32
+            return static_cast<long>(_getpid());
+#else
+            return static_cast<long>(getpid());
+#endif
+        }
+
+        static unsigned long nextTemporary()
+        {
+            static std::atomic<unsigned long> count(0);
+            return ++count;
+        }
+
+        ProgramCache(const ProgramCache&);
+        ProgramCache& operator=(const ProgramCache&);
+
+        std::string my_directory;
+        mutable std::mutex my_mutex;
+        Statistics my_statistics;
+}; // class ProgramCache
+
+} // namespace clpp
+
+#endif // CLPP_PROGRAMCACHE_HPP
@@ -0,0 +1,194 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_PROGRAMTEMPLATE_HPP
+#define CLPP_PROGRAMTEMPLATE_HPP
+
+#include <future>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "common.hpp"
+#include "error.hpp"
+#include "context.hpp"
+#include "program.hpp"
+#include "typename.hpp"
+
+namespace clpp {
+
+/// A program source specialized by preprocessor definitions.
+/** A program template builds variants of the same source with different
+    \c -D options, and keeps every built variant, so switching between
+    specializations costs a map lookup after the first build, e.g.
+
+    \code
+    ProgramTemplate gemm(context, source);
+    Program p = gemm.get(ProgramTemplate::Parameters()
+                         .type<cl_float4>("TYPE")
+                         .value("TILE", 16));
+    \endcode
+
+    builds \c source with <tt>-DTILE=16 -DTYPE=float4</tt>. The parameters
+    are sorted by name, so the same set of parameters always gives the same
+    options, whatever order they are given in. If the program cache of the
+    context is enabled, the binaries of the variants are stored on disk too.
+
+    Copies of a program template share the variants. All member functions
+    are thread-safe, and a variant requested by several threads at once is
+    built only once.
+ */
+class ProgramTemplate {
+    public:
+        /// A set of preprocessor definitions.
+        class Parameters {
+            public:
+                /// Define a macro as the OpenCL C name of a host type.
+                /** For example, <tt>type<cl_float4>("TYPE")</tt> defines
+                    \c TYPE as \c float4.
+                 */
+                template <typename T> Parameters& type(const std::string& name)
+                {
+                    static_assert(TypeName<T>::defined, "T has no OpenCL C type name");
+                    return define(name, TypeName<T>::name());
+                }
+
+                /// Define a macro as a number.
+                /** Floating-point values are written with full precision,
+                    and \c float values get the \c f suffix.
+                 */
+                template <typename T> Parameters& value(const std::string& name, T v)
+                {
+                    static_assert(std::is_arithmetic<T>::value, "T is not a number");
+                    std::ostringstream s;
+                    if(std::is_floating_point<T>::value)
+                        s << std::showpoint << std::setprecision(std::numeric_limits<T>::max_digits10);
+                    s << +v;
+                    if(std::is_same<T, float>::value)
+                        s << 'f';
+                    return define(name, s.str());
+                }
+
+                /// Define a macro as a piece of text.
+                /**
+                    \param name     The name of the macro.
+                    \param text     The replacement text. If it is empty,
+                                    the macro is defined without a value.
+                 */
+                Parameters& define(const std::string& name, const std::string& text = std::string())
+                {
+                    my_defines[name] = text;
+                    return *this;
+                }
+
+                /// Get the canonical compiler options of the definitions.
+                std::string options() const
+                {
+                    std::string result;
+                    for(std::map<std::string, std::string>::const_iterator i = my_defines.begin(); i != my_defines.end(); ++i){
+                        if(!result.empty())
+                            result += ' ';
+                        result += "-D" + i->first;
+                        if(!i->second.empty())
+                            result += '=' + i->second;
+                    }
+                    return result;
+                }
+
+            private:
+                std::map<std::string, std::string> my_defines;
+        }; // class ProgramTemplate::Parameters
+
+        /// Construct a program template.
+        /**
+            \param context  The context where the variants are built.
+            \param source   The program source code.
+            \param options  Compiler options common to all variants.
+         */
+        ProgramTemplate(const Context& context, const std::string& source, const std::string& options = std::string())
+            : my_state(new State(context, source, options))
+        {}
+
+        /// Get the program built with the given parameters.
+        /** The variant is built the first time it is requested. If its build
+            fails, the Program::BuildError is thrown again on later requests.
+         */
+        Program get(const Parameters& params)
+        {
+            return variant(params).get();
+        }
+
+        /// Start building variants in the background.
+        /** Variants are queued to the background build workers of the
+            context, see Context::prebuild(). Variants which are already
+            built or being built are skipped. get() waits for a variant
+            which is still being built.
+         */
+        void prebuild(const std::vector<Parameters>& params)
+        {
+            for(size_t i = 0; i < params.size(); ++i)
+                variant(params[i]);
+        }
+
+        /// Get the full compiler options of a variant.
+        std::string options(const Parameters& params) const
+        {
+            std::string defines = params.options();
+            if(my_state->options.empty())
+                return defines;
+            if(defines.empty())
+                return my_state->options;
+            return my_state->options + ' ' + defines;
+        }
+
+        /// Get the number of variants built or being built.
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(my_state->mutex);
+            return my_state->variants.size();
+        }
+
+    private:
+        struct State {
+            State(const Context& c, const std::string& s, const std::string& o)
+                : context(c), source(s), options(o)
+            {}
+
+            Context context;
+            std::string source;
+            std::string options;
+            std::mutex mutex;
+            std::map< std::string, std::shared_future<Program> > variants;
+        };
+
+        std::shared_future<Program> variant(const Parameters& params)
+        {
+            std::string opts = options(params);
+            std::lock_guard<std::mutex> lock(my_state->mutex);
+            std::map< std::string, std::shared_future<Program> >::iterator i = my_state->variants.find(opts);
+            if(i != my_state->variants.end())
+                return i->second;
+
+            // Context::prebuild never blocks, even if the OpenCL
+            // implementation builds synchronously, so the lock is held only
+            // briefly.
+            std::shared_future<Program> f = my_state->context.prebuild(
+                    std::vector<std::string>(1, my_state->source), opts.c_str(), 1)[0].share();
+            my_state->variants.insert(std::make_pair(opts, f));
+            return f;
+        }
+
+        std::shared_ptr<State> my_state;
+}; // class ProgramTemplate
+
+} // namespace clpp
+
+#endif // CLPP_PROGRAMTEMPLATE_HPP
@@ -6,11 +6,44 @@
 #ifndef CLPP_RESOURCE_HPP
 #define CLPP_RESOURCE_HPP
 
+#include <utility>
+
 #include "common.hpp"
 #include "error.hpp"
 
+#ifdef CLPP_COUNT_RESOURCE_CALLS
+#include <atomic>
+#endif
+
 namespace clpp {
 
+#ifdef CLPP_COUNT_RESOURCE_CALLS
+/// Counters of retain and release calls made by Resource.
+/** The counters are only available when \c CLPP_COUNT_RESOURCE_CALLS is
+    defined before including clpp. They are intended for benchmarks which
+    measure the reference counting overhead of the wrapper classes.
+ */
+struct ResourceCounters {
+    /// Number of calls to the retain function of any handle type.
+    static std::atomic<unsigned long>& retains()
+    {
+        static std::atomic<unsigned long> count(0);
+        return count;
+    }
+
+    /// Number of calls to the release function of any handle type.
+    static std::atomic<unsigned long>& releases()
+    {
+        static std::atomic<unsigned long> count(0);
+        return count;
+    }
+}; // struct ResourceCounters
+
+#define CLPP_COUNT_RESOURCE_CALL(counter) (++ResourceCounters::counter())
+#else
+#define CLPP_COUNT_RESOURCE_CALL(counter) ((void)0)
+#endif
+
 template <typename Handle> struct ResourcePolicy;
 
 template <> struct ResourcePolicy<cl_context> {
@@ -49,6 +82,14 @@ template <> struct ResourcePolicy<cl_event> {
     static cl_int release(cl_event h) throw() { return clReleaseEvent(h); }
 }; // struct ResourcePolicy<cl_event>
 
+#ifdef CL_VERSION_1_2
+template <> struct ResourcePolicy<cl_device_id> {
+    static cl_device_id null() throw() { return 0; }
+    static cl_int retain(cl_device_id h) { return clRetainDevice(h); }
+    static cl_int release(cl_device_id h) throw() { return clReleaseDevice(h); }
+}; // struct ResourcePolicy<cl_device_id>
+#endif
+
 /// A general resource wrapper.
 template <typename Handle> class Resource {
     public:
@@ -60,14 +101,26 @@ template <typename Handle> class Resource {
 
         Resource(const Resource& r) : my_handle(r.my_handle)
         {
-            if(my_handle != Policy::null())
+            if(my_handle != Policy::null()){
+                CLPP_COUNT_RESOURCE_CALL(retains);
                 CLPP_CHECK_ERROR(Policy::retain(my_handle));
+            }
+        }
+
+        /// Take over the handle of another resource without retaining it.
+        /** After the move, \a r holds a null handle.
+         */
+        Resource(Resource&& r) throw() : my_handle(r.my_handle)
+        {
+            r.my_handle = Policy::null();
         }
 
         void reset(Handle h)
         {
-            if(my_handle != Policy::null() && my_handle != h)
+            if(my_handle != Policy::null() && my_handle != h){
+                CLPP_COUNT_RESOURCE_CALL(releases);
                 CLPP_CHECK_ERROR(Policy::release(my_handle));
+            }
 
             my_handle = h;
         }
@@ -84,10 +137,19 @@ template <typename Handle> class Resource {
             return *this;
         }
 
+        Resource& operator=(Resource&& r) throw()
+        {
+            Resource<Handle> tmp(std::move(r));
+            swap(tmp);
+            return *this;
+        }
+
         ~Resource() throw()
         {
-            if(my_handle != Policy::null())
+            if(my_handle != Policy::null()){
+                CLPP_COUNT_RESOURCE_CALL(releases);
                 Policy::release(my_handle);
+            }
         }
 
         void swap(Resource<Handle>& r) throw()
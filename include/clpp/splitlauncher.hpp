@@ -0,0 +1,368 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_SPLITLAUNCHER_HPP
+#define CLPP_SPLITLAUNCHER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common.hpp"
+#include "error.hpp"
+#include "size.hpp"
+#include "context.hpp"
+#include "commandqueue.hpp"
+#include "buffer.hpp"
+#include "kernel.hpp"
+#include "event.hpp"
+
+namespace clpp {
+
+#ifdef CL_VERSION_1_1
+/// The part of a range executed by one device of a SplitLauncher.
+/** A 1-D range is split along its only dimension, and a 2-D range is split
+    along dimension 1, i.e. into bands of whole rows, so each part covers a
+    contiguous range of row-major data.
+ */
+struct Split {
+    /// The index of the device and its command queue in the context.
+    size_t index;
+
+    /// The device which executes this part.
+    Device device;
+
+    /// The number of dimensions of the whole range.
+    cl_uint dim;
+
+    /// The global ID of the first work-item of this part.
+    size2 offset;
+
+    /// The number of work-items of this part in each dimension.
+    size2 size;
+
+    /// Get the linear index of the first work-item in the whole range.
+    size_t first() const
+    {
+        return dim == 1 ? offset.s[0] : offset.s[1] * size.s[0];
+    }
+
+    /// Get the number of work-items in this part.
+    size_t count() const
+    {
+        return dim == 1 ? size.s[0] : size.s[0] * size.s[1];
+    }
+
+    /// Get the part of a buffer which corresponds to this part of the range.
+    /** The view is backed by a sub-buffer if the device allows it, so the
+        kernel sees only the elements of this part, indexed from
+        <tt>get_global_id(0) - get_global_offset(0)</tt> (or dimension 1 for
+        2-D ranges). Otherwise BufferView::offset() must be passed to the
+        kernel, see Buffer::slice.
+
+        \param buffer   The buffer with elements for the whole range.
+        \param per_item The number of elements per work-item.
+     */
+    template <typename T> BufferView<T> slice(const Buffer<T>& buffer, size_t per_item = 1) const
+    {
+        return buffer.slice(first() * per_item, count() * per_item, device);
+    }
+};
+
+/// A launcher which splits a range over all devices of a context.
+/** A split launcher executes a kernel over a 1-D or 2-D range, split into
+    one part per device of the context, e.g. per GPU or per sub-device of a
+    partitioned CPU. Each part is executed on the command queue of its
+    device, with the global offset of the part. Each device uses its own
+    clone of the kernel, so the binder binds the arguments of each part,
+    e.g. Split::slice of the buffers it writes:
+
+    \code
+    // kernel void scale(global const float* in, global float* out, int base)
+    // {
+    //     size_t i = get_global_id(0);
+    //     out[i - get_global_offset(0) + base] = 2 * in[i];
+    // }
+    std::vector< BufferView<cl_float> > parts(launcher.size());
+    Event done = launcher.exec(n, 64, [&](Kernel& k, const Split& s){
+        parts[s.index] = s.slice(output);
+        k.setArgs(input, parts[s.index], cl_int(parts[s.index].offset()));
+    });
+    done.wait();
+    context.queue().copy(output, &result[0]);
+    \endcode
+
+    OpenCL doesn't define the result of several devices writing one memory
+    object at the same time, so binding a whole buffer to every part is
+    only safe for arguments which the kernel doesn't write. Writes should
+    go through the slices, which must stay alive until the returned event
+    is complete, and the results are read from the whole buffer after it.
+
+    Parts are proportional to the throughput of each device, measured from
+    previous launches when their commands complete. Before the first
+    measurement, the throughput is estimated from the number of compute
+    units and the clock frequency. If the queues have profiling enabled,
+    device execution times are used; otherwise host time from enqueue to
+    completion is used.
+
+    Copies of a launcher share the kernels and the measurements. It must
+    not be used by several threads at the same time.
+ */
+class SplitLauncher {
+    public:
+        /// The function which binds kernel arguments for a part.
+        typedef std::function<void(Kernel&, const Split&)> Binder;
+
+        /// Construct a split launcher.
+        /**
+            \param context  The context whose devices execute the kernel.
+            \param k        The kernel. It is used for the first device and
+                            cloned for the others.
+         */
+        SplitLauncher(const Context& context, const Kernel& k)
+            : my_context(context), my_stats(new Stats)
+        {
+            const DeviceList& devices = my_context.devices();
+            for(size_t d = 0; d < devices.size(); ++d){
+                my_kernels.push_back(d == 0 ? k : k.clone());
+                double estimate = static_cast<double>(devices[d].getMaxComputeUnits()) * devices[d].getMaxClockFrequency();
+                my_stats->estimates.push_back(std::max(estimate, 1.0));
+                my_stats->rates.push_back(0);
+                my_stats->measured.push_back(false);
+            }
+        }
+
+        /// Get the number of devices.
+        size_t size() const
+        {
+            return my_kernels.size();
+        }
+
+        /// Get the kernel used by a device.
+        Kernel& kernel(size_t i)
+        {
+            return my_kernels[i];
+        }
+
+        /// Execute the kernel over a 1-D range.
+        /**
+            \param global_size  The number of global work-items.
+            \param local_size   The number of work-items in a work-group.
+                                Each part is a multiple of it. If it is 0,
+                                the OpenCL implementation chooses it.
+            \param bind         The function which binds the arguments for
+                                each part.
+            \param wait_list    Events that need to complete before any part
+                                can be executed.
+
+            \return             An event which is complete when all parts
+                                are complete.
+         */
+        Event exec(size_t global_size, size_t local_size, const Binder& bind, const EventList& wait_list = EventList())
+        {
+            return launch(1, size2(global_size, 1), size2(local_size, 1), bind, wait_list);
+        }
+
+        /// Execute the kernel over a 2-D range.
+        /** The range is split into bands of rows. See
+            exec(size_t, size_t, const Binder&, const EventList&).
+         */
+        Event exec(size2 global_size, size2 local_size, const Binder& bind, const EventList& wait_list = EventList())
+        {
+            return launch(2, global_size, local_size, bind, wait_list);
+        }
+
+        /// Get the throughput of each device.
+        /**
+            \return     Work-items per second of each device. Devices which
+                        haven't completed a part yet are estimated from the
+                        measured ones, by their compute units and clock
+                        frequencies. Only the ratios are meaningful before
+                        the first measurement.
+         */
+        std::vector<double> throughput() const
+        {
+            std::lock_guard<std::mutex> lock(my_stats->mutex);
+            const Stats& st = *my_stats;
+            double scale = 0;
+            size_t measured = 0;
+            for(size_t d = 0; d < st.rates.size(); ++d){
+                if(st.measured[d]){
+                    scale += st.rates[d] / st.estimates[d];
+                    ++measured;
+                }
+            }
+            if(measured == 0)
+                return st.estimates;
+
+            scale /= measured;
+            std::vector<double> result(st.rates.size());
+            for(size_t d = 0; d < result.size(); ++d)
+                result[d] = st.measured[d] ? st.rates[d] : st.estimates[d] * scale;
+            return result;
+        }
+
+        /// Get the sizes of the parts the next launch would use.
+        /**
+            \param total        The size of the range in the split dimension.
+            \param granularity  Each part is a multiple of it.
+
+            \return             The size of the part of each device.
+         */
+        std::vector<size_t> partition(size_t total, size_t granularity = 1) const
+        {
+            return partition(throughput(), total, granularity);
+        }
+
+        /// Split a range in proportion to given throughputs.
+        /** Parts are computed in units of \a granularity, and the units
+            left by rounding down go to the parts with the largest
+            remainders. The last non-empty part is cut at the end of the
+            range.
+
+            \param rates        The throughput of each device.
+            \param total        The size of the range in the split dimension.
+            \param granularity  Each part is a multiple of it.
+
+            \return             The size of the part of each device.
+         */
+        static std::vector<size_t> partition(const std::vector<double>& rates, size_t total, size_t granularity = 1)
+        {
+            if(granularity == 0)
+                granularity = 1;
+            if(rates.empty())
+                return std::vector<size_t>();
+            double sum = 0;
+            for(size_t d = 0; d < rates.size(); ++d)
+                sum += rates[d];
+
+            // Split the units in proportion to the rates, and give the
+            // remaining units to the largest remainders.
+            size_t units = (total + granularity - 1) / granularity;
+            std::vector<size_t> result(rates.size(), 0);
+            std::vector<double> remainder(rates.size(), 0);
+            size_t assigned = 0;
+            for(size_t d = 0; d < rates.size(); ++d){
+                double share = sum > 0 ? units * rates[d] / sum : static_cast<double>(units) / rates.size();
+                result[d] = static_cast<size_t>(share);
+                remainder[d] = share - result[d];
+                assigned += result[d];
+            }
+            for(; assigned < units; ++assigned){
+                size_t best = 0;
+                for(size_t d = 1; d < rates.size(); ++d)
+                    if(remainder[d] > remainder[best])
+                        best = d;
+                ++result[best];
+                remainder[best] = -1;
+            }
+
+            // The last non-empty part ends at the end of the range.
+            size_t end = 0;
+            for(size_t d = 0; d < result.size(); ++d){
+                result[d] *= granularity;
+                end += result[d];
+            }
+            for(size_t d = result.size(); d-- > 0 && end > total; ){
+                size_t cut = std::min(end - total, result[d]);
+                result[d] -= cut;
+                end -= cut;
+            }
+            return result;
+        }
+
+    private:
+        struct Stats {
+            std::mutex mutex;
+            std::vector<double> estimates;
+            std::vector<double> rates;
+            std::vector<bool> measured;
+        };
+
+        // A part waiting for completion, owned by its event callback.
+        struct Pending {
+            std::shared_ptr<Stats> stats;
+            size_t index;
+            size_t items;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        Event launch(cl_uint dim, size2 global_size, size2 local_size, const Binder& bind, const EventList& wait_list)
+        {
+            cl_uint axis = dim - 1;
+            bool no_local = local_size.s[0] == 0 || local_size.s[1] == 0;
+            std::vector<size_t> parts = partition(global_size.s[axis], no_local ? 1 : local_size.s[axis]);
+
+            EventList events;
+            size_t begin = 0;
+            for(size_t d = 0; d < parts.size(); ++d){
+                if(parts[d] == 0)
+                    continue;
+
+                Split s = { d, my_context.devices()[d], dim, size2(0, 0), global_size };
+                s.offset.s[axis] = begin;
+                s.size.s[axis] = parts[d];
+                begin += parts[d];
+                bind(my_kernels[d], s);
+
+                CommandQueue& q = my_context.queue(d);
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                Event e = dim == 1
+                    ? q.execOffset(my_kernels[d], s.offset.s[0], s.size.s[0], local_size.s[0], wait_list)
+                    : q.execOffset(my_kernels[d], s.offset, s.size, local_size, wait_list);
+                if(e.id() == 0)
+                    e = q.marker();
+                q.flush();
+
+                Pending* p = new Pending;
+                p->stats = my_stats;
+                p->index = d;
+                p->items = s.count();
+                p->start = start;
+                cl_int err = clSetEventCallback(e.id(), CL_COMPLETE, &onComplete, p);
+                if(err != CL_SUCCESS)
+                    delete p;
+                CLPP_CHECK_ERROR(err);
+                events.append(e);
+            }
+            return my_context.queue().marker(events);
+        }
+
+        static void CL_CALLBACK onComplete(cl_event event, cl_int status, void* user_data)
+        {
+            Pending* p = static_cast<Pending*>(user_data);
+            if(status == CL_COMPLETE){
+                double seconds;
+                cl_ulong start, end;
+                if(clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(start), &start, NULL) == CL_SUCCESS
+                   && clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL) == CL_SUCCESS)
+                    seconds = (end - start) * 1e-9;
+                else
+                    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - p->start).count();
+
+                if(seconds > 0){
+                    // Average with the previous measurement to damp noise.
+                    double rate = p->items / seconds;
+                    std::lock_guard<std::mutex> lock(p->stats->mutex);
+                    double& r = p->stats->rates[p->index];
+                    r = p->stats->measured[p->index] ? (r + rate) / 2 : rate;
+                    p->stats->measured[p->index] = true;
+                }
+            }
+            delete p;
+        }
+
+        Context my_context;
+        std::vector<Kernel> my_kernels;
+        std::shared_ptr<Stats> my_stats;
+}; // class SplitLauncher
+#endif
+
+} // namespace clpp
+
+#endif // CLPP_SPLITLAUNCHER_HPP
@@ -0,0 +1,417 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_TASKGRAPH_HPP
+#define CLPP_TASKGRAPH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "error.hpp"
+#include "context.hpp"
+#include "commandqueue.hpp"
+#include "buffer.hpp"
+#include "kernel.hpp"
+#include "kernelfunctor.hpp"
+#include "event.hpp"
+
+namespace clpp {
+
+/// A graph of commands with data dependencies.
+/** A task graph describes a pipeline of kernel executions, copies and host
+    functions, where each node only waits for the nodes it depends on, e.g.
+
+    \code
+    TaskGraph graph(context, 2);
+    TaskGraph::Node a = graph.addWrite("upload a", &ha[0], da);
+    TaskGraph::Node b = graph.addWrite("upload b", &hb[0], db);
+    TaskGraph::Node k = graph.addKernel("add", add, NDRange(n), {a, b});
+    graph.addRead("download", dc, &hc[0], {k});
+    graph.run().wait();
+    \endcode
+
+    The graph is compiled once, when it is first run after a change. Device
+    nodes are spread over several in-order command queues: a node is put on
+    the queue of one of its dependencies if that dependency was the last
+    node of the queue, so the queue order already implies the dependency,
+    and on the least recently used queue otherwise. Dependencies on other
+    queues become event wait lists. Replaying the graph then only enqueues
+    the commands with precomputed wait lists.
+
+    Host nodes are run by the thread calling run(), after their
+    dependencies complete, and as late as the dependencies of other nodes
+    allow, so device nodes are enqueued before the host blocks.
+
+    The queues are created with profiling enabled, so that criticalPath()
+    can report the longest chain of dependent nodes of the last run.
+ */
+class TaskGraph {
+    public:
+        /// The index of a node.
+        typedef size_t Node;
+
+        /// The function which enqueues a device node.
+        /** It takes the command queue and the events the command must wait
+            for, and returns the event of the command.
+         */
+        typedef std::function<Event(CommandQueue&, const EventList&)> Command;
+
+        /// The longest chain of dependent nodes of a run.
+        struct CriticalPath {
+            /// The nodes of the chain, in execution order.
+            std::vector<Node> nodes;
+            /// The sum of the execution times of the nodes, in nanoseconds.
+            cl_ulong time;
+        };
+
+        /// Construct an empty task graph.
+        /**
+            \param context      The context where the graph runs.
+            \param num_queues   The number of command queues the nodes are
+                                spread over.
+            \param device       The index of the device in the context.
+         */
+        TaskGraph(Context& context, size_t num_queues = 2, size_t device = 0) : my_compiled(false)
+        {
+            const Device& d = context.devices()[device];
+            for(size_t i = 0; i < std::max<size_t>(num_queues, 1); ++i){
+                cl_int err;
+                cl_command_queue q = clCreateCommandQueue(context.id(), d.id(), CL_QUEUE_PROFILING_ENABLE, &err);
+                CLPP_CHECK_ERROR(err);
+                my_queues.push_back(CommandQueue(q, d));
+            }
+        }
+
+        /// Add a device node.
+        /**
+            \param name     The name of the node, used in reports.
+            \param command  The function which enqueues the command.
+            \param after    The nodes this node depends on.
+
+            \return         The new node.
+         */
+        Node add(const std::string& name, const Command& command, const std::vector<Node>& after = std::vector<Node>())
+        {
+            return addNode(name, false, command, std::function<void()>(), after);
+        }
+
+        /// Add a kernel execution.
+        /** The arguments bound to \a k when the graph is run are used, so
+            nodes which execute the same kernel function with different
+            arguments need different kernel objects, e.g. from
+            Program::createKernel.
+         */
+        Node addKernel(const std::string& name, const Kernel& k, const NDRange& range, const std::vector<Node>& after = std::vector<Node>())
+        {
+            return add(name, [k, range](CommandQueue& q, const EventList& wait_list){ return range.exec(q, k, wait_list); }, after);
+        }
+
+        /// Add a copy between buffers.
+        template <typename T> Node addCopy(const std::string& name, const Buffer<T>& src, const Buffer<T>& dst, const std::vector<Node>& after = std::vector<Node>())
+        {
+            return add(name, [src, dst](CommandQueue& q, const EventList& wait_list){ return q.copy(src, dst, 0, wait_list); }, after);
+        }
+
+        /// Add a non-blocking write from host memory to a buffer.
+        template <typename T> Node addWrite(const std::string& name, const T* ptr, const Buffer<T>& dst, const std::vector<Node>& after = std::vector<Node>())
+        {
+            return add(name, [ptr, dst](CommandQueue& q, const EventList& wait_list){ return q.copy(ptr, dst, CL_FALSE, wait_list); }, after);
+        }
+
+        /// Add a non-blocking read from a buffer to host memory.
+        template <typename T> Node addRead(const std::string& name, const Buffer<T>& src, T* ptr, const std::vector<Node>& after = std::vector<Node>())
+        {
+            return add(name, [src, ptr](CommandQueue& q, const EventList& wait_list){ return q.copy(src, ptr, CL_FALSE, wait_list); }, after);
+        }
+
+        /// Add a host function.
+        /** The function is called by the thread calling run(), after the
+            nodes in \a after are complete.
+         */
+        Node addHost(const std::string& name, const std::function<void()>& function, const std::vector<Node>& after = std::vector<Node>())
+        {
+            return addNode(name, true, Command(), function, after);
+        }
+
+        /// Get the number of nodes.
+        size_t size() const
+        {
+            return my_nodes.size();
+        }
+
+        /// Get the name of a node.
+        const std::string& name(Node n) const
+        {
+            return my_nodes[n].name;
+        }
+
+        /// Get the command queue a device node is assigned to.
+        /**
+            \return     The index of the queue, or size_t(-1) for host nodes.
+         */
+        size_t queue(Node n)
+        {
+            compile();
+            return my_nodes[n].queue;
+        }
+
+        /// Get the number of command queues.
+        size_t numQueues() const
+        {
+            return my_queues.size();
+        }
+
+        /// Assign the nodes to command queues and compute the wait lists.
+        /** It is called by run() if the graph has changed, and only needs to
+            be called directly to move the work out of the first run.
+         */
+        void compile()
+        {
+            if(my_compiled)
+                return;
+
+            size_t num = my_nodes.size();
+            my_order.clear();
+            std::vector<size_t> pending(num);
+            std::vector< std::vector<Node> > dependents(num);
+            for(Node n = 0; n < num; ++n){
+                pending[n] = my_nodes[n].after.size();
+                for(size_t i = 0; i < my_nodes[n].after.size(); ++i)
+                    dependents[my_nodes[n].after[i]].push_back(n);
+            }
+
+            // Order the nodes topologically, taking host nodes only when no
+            // device node is ready.
+            std::vector<bool> done(num, false);
+            while(my_order.size() < num){
+                Node next = num;
+                for(Node n = 0; n < num; ++n){
+                    if(done[n] || pending[n] != 0)
+                        continue;
+                    if(!isHost(n)){
+                        next = n;
+                        break;
+                    }
+                    if(next == num)
+                        next = n;
+                }
+                done[next] = true;
+                my_order.push_back(next);
+                for(size_t i = 0; i < dependents[next].size(); ++i)
+                    --pending[dependents[next][i]];
+            }
+
+            // Assign the queues and compute the wait lists.
+            std::vector<Node> tail(my_queues.size(), num);
+            std::vector<size_t> last_use(my_queues.size(), 0);
+            for(size_t step = 0; step < num; ++step){
+                Node n = my_order[step];
+                NodeData& node = my_nodes[n];
+                node.waits.clear();
+                if(isHost(n)){
+                    node.queue = size_t(-1);
+                    for(size_t i = 0; i < node.after.size(); ++i)
+                        if(!isHost(node.after[i]))
+                            node.waits.push_back(node.after[i]);
+                    continue;
+                }
+
+                size_t q = my_queues.size();
+                for(size_t i = 0; i < node.after.size() && q == my_queues.size(); ++i)
+                    for(size_t j = 0; j < my_queues.size(); ++j)
+                        if(tail[j] == node.after[i])
+                            q = j;
+                if(q == my_queues.size()){
+                    q = 0;
+                    for(size_t j = 1; j < my_queues.size(); ++j)
+                        if(last_use[j] < last_use[q])
+                            q = j;
+                }
+                node.queue = q;
+                tail[q] = n;
+                last_use[q] = step + 1;
+
+                // Host dependencies are complete before this node is
+                // enqueued, and the queue order covers the same queue.
+                for(size_t i = 0; i < node.after.size(); ++i){
+                    Node d = node.after[i];
+                    if(!isHost(d) && my_nodes[d].queue != q)
+                        node.waits.push_back(d);
+                }
+            }
+            my_compiled = true;
+        }
+
+        /// Run the graph once.
+        /** This function returns after all device nodes are enqueued and all
+            host nodes have been called.
+
+            The nodes without dependencies wait for the previous run to
+            complete, so a run can be started before the event of the
+            previous one is complete, without any node overwriting data
+            which a node of the previous run still uses.
+
+            \return     An event which is complete when all nodes are
+                        complete.
+         */
+        Event run()
+        {
+            compile();
+            Event previous = my_last_run;
+            my_events.assign(my_nodes.size(), Event());
+            std::vector<bool> used(my_queues.size(), false);
+            for(size_t step = 0; step < my_order.size(); ++step){
+                Node n = my_order[step];
+                NodeData& node = my_nodes[n];
+                EventList wait_list;
+                for(size_t i = 0; i < node.waits.size(); ++i)
+                    wait_list.append(my_events[node.waits[i]]);
+                // Other nodes follow the previous run through their
+                // dependencies.
+                if(node.after.empty() && previous.id() != 0)
+                    wait_list.append(previous);
+
+                if(isHost(n)){
+                    for(size_t q = 0; q < my_queues.size(); ++q)
+                        if(used[q])
+                            my_queues[q].flush();
+                    wait_list.wait();
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    node.function();
+                    node.host_time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                    continue;
+                }
+
+                CommandQueue& q = my_queues[node.queue];
+                Event e = node.command(q, wait_list);
+                if(e.id() == 0)
+                    e = q.marker();
+                my_events[n] = e;
+                used[node.queue] = true;
+            }
+
+            std::vector<Node> last(my_queues.size(), my_nodes.size());
+            for(size_t step = 0; step < my_order.size(); ++step)
+                if(!isHost(my_order[step]))
+                    last[my_nodes[my_order[step]].queue] = my_order[step];
+            EventList tails;
+            for(size_t q = 0; q < my_queues.size(); ++q){
+                if(used[q]){
+                    tails.append(my_events[last[q]]);
+                    my_queues[q].flush();
+                }
+            }
+            my_last_run = my_queues[0].marker(tails);
+            return my_last_run;
+        }
+
+        /// Get the execution time of a node in the last run.
+        /** This function waits for the last run to complete.
+
+            \return     The execution time in nanoseconds, measured by the
+                        device for device nodes and by the host for host
+                        nodes.
+         */
+        cl_ulong time(Node n) const
+        {
+            waitLastRun();
+            if(isHost(n))
+                return my_nodes[n].host_time;
+            return my_events[n].getExecutionTime();
+        }
+
+        /// Get the critical path of the last run.
+        /** The critical path is the chain of dependent nodes with the
+            largest sum of execution times. It bounds the time of a run no
+            matter how many queues are used, so it shows which nodes to
+            optimize. This function waits for the last run to complete.
+         */
+        CriticalPath criticalPath() const
+        {
+            waitLastRun();
+            size_t num = my_nodes.size();
+            std::vector<cl_ulong> finish(num, 0);
+            std::vector<Node> previous(num, num);
+            CriticalPath result;
+            result.time = 0;
+            Node end = num;
+            for(size_t step = 0; step < my_order.size(); ++step){
+                Node n = my_order[step];
+                const std::vector<Node>& after = my_nodes[n].after;
+                for(size_t i = 0; i < after.size(); ++i){
+                    if(previous[n] == num || finish[after[i]] > finish[previous[n]])
+                        previous[n] = after[i];
+                }
+                finish[n] = time(n) + (previous[n] == num ? 0 : finish[previous[n]]);
+                if(end == num || finish[n] > finish[end])
+                    end = n;
+            }
+
+            if(end != num){
+                result.time = finish[end];
+                for(Node n = end; n != num; n = previous[n])
+                    result.nodes.insert(result.nodes.begin(), n);
+            }
+            return result;
+        }
+
+    private:
+        struct NodeData {
+            std::string name;
+            bool host;
+            Command command;
+            std::function<void()> function;
+            std::vector<Node> after;
+            size_t queue;
+            std::vector<Node> waits;
+            cl_ulong host_time;
+        };
+
+        Node addNode(const std::string& name, bool host, const Command& command, const std::function<void()>& function, const std::vector<Node>& after)
+        {
+            // Dependencies must exist, so the graph is always acyclic.
+            for(size_t i = 0; i < after.size(); ++i)
+                if(after[i] >= my_nodes.size())
+                    throw Error(CL_INVALID_VALUE, __FILE__, __FUNCTION__, __LINE__);
+
+            NodeData node;
+            node.name = name;
+            node.host = host;
+            node.command = command;
+            node.function = function;
+            node.after = after;
+            node.queue = 0;
+            node.host_time = 0;
+            my_nodes.push_back(node);
+            my_compiled = false;
+            return my_nodes.size() - 1;
+        }
+
+        bool isHost(Node n) const
+        {
+            return my_nodes[n].host;
+        }
+
+        void waitLastRun() const
+        {
+            Event e = my_last_run;
+            e.wait();
+        }
+
+        std::vector<CommandQueue> my_queues;
+        std::vector<NodeData> my_nodes;
+        std::vector<Node> my_order;
+        std::vector<Event> my_events;
+        Event my_last_run;
+        bool my_compiled;
+}; // class TaskGraph
+
+} // namespace clpp
+
+#endif // CLPP_TASKGRAPH_HPP
@@ -0,0 +1,358 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_TUNER_HPP
+#define CLPP_TUNER_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "error.hpp"
+#include "resource.hpp"
+#include "size.hpp"
+#include "device.hpp"
+#include "event.hpp"
+#include "kernel.hpp"
+#include "platform.hpp"
+#include "program.hpp"
+
+namespace clpp {
+
+/// A persistent kernel launch autotuner.
+/** The tuner benchmarks candidate work-group sizes, and optionally several
+    sets of compiler options such as \c -D tile parameters, for a kernel on a
+    device, using the profiling timestamps of events. The fastest
+    configuration is recorded per kernel name, device name and global size
+    bucket, and saved to a file so that it can be reused by later runs.
+
+    A bucket groups global sizes whose dimensions have the same binary
+    logarithm, e.g. 1000 and 600 share the bucket of 512.
+
+    Once a tuner is attached to a command queue by CommandQueue::setTuner,
+    CommandQueue::exec and CommandQueue::execAuto use the tuned work-group
+    size automatically. Tuned compiler options can't be applied to an
+    already built program; use lookup() to get them.
+
+    All member functions are thread-safe.
+ */
+class KernelTuner {
+    public:
+        /// A tuned launch configuration.
+        struct Config {
+            /// The work-group size.
+            size3 local_size;
+            /// The compiler options of the program.
+            std::string options;
+            /// The measured execution time in nanoseconds.
+            cl_ulong time;
+        };
+
+        /// Construct a tuner and load the configurations saved in a file.
+        /**
+            \param filename     The file where tuned configurations are
+                                stored. It is fine if the file doesn't exist
+                                yet.
+         */
+        explicit KernelTuner(const std::string& filename) : my_filename(filename)
+        {
+            load();
+        }
+
+        /// Get the file where tuned configurations are stored.
+        const std::string& filename() const
+        {
+            return my_filename;
+        }
+
+        /// Get the bucket of a global size.
+        /**
+            \param dim          The number of dimensions.
+            \param global_size  The global size in each dimension.
+            \return             The bucket as a string, e.g. "9,4".
+         */
+        static std::string bucket(cl_uint dim, const size_t* global_size)
+        {
+            std::string s;
+            appendBucket(s, dim, global_size);
+            return s;
+        }
+
+        /// Look up the tuned configuration of a kernel.
+        /**
+            \param kernel_name  The name of the kernel function.
+            \param device_name  The name of the device.
+            \param dim          The number of dimensions.
+            \param global_size  The global size in each dimension.
+            \param config       Receives the tuned configuration.
+
+            \return             \a true if a configuration is found.
+         */
+        bool lookup(const std::string& kernel_name, const std::string& device_name, cl_uint dim, const size_t* global_size, Config& config) const
+        {
+            std::string key = makeKey(kernel_name, device_name, dim, global_size);
+            std::lock_guard<std::mutex> lock(my_mutex);
+            std::map<std::string, Config>::const_iterator i = my_configs.find(key);
+            if(i == my_configs.end())
+                return false;
+            config = i->second;
+            return true;
+        }
+
+        /// Generate candidate work-group sizes for a kernel.
+        /** The candidates are all combinations of powers of two which fit
+            in the work-group size limits of the kernel and the device.
+
+            \param kernel   The kernel to be tuned.
+            \param device   The device where the kernel is executed.
+            \param dim      The number of dimensions.
+
+            \return         The candidate work-group sizes.
+         */
+        static std::vector<size3> candidates(const Kernel& kernel, Device device, cl_uint dim)
+        {
+            size_t max_size = kernel.getWorkGroupInfo<size_t>(device, CL_KERNEL_WORK_GROUP_SIZE);
+            std::vector<size_t> max_items = device.getMaxWorkItemSizes();
+            std::vector<size3> result;
+            for(size_t x = 1; x <= max_size && x <= max_items[0]; x *= 2){
+                for(size_t y = 1; x*y <= max_size && (dim > 1 ? y <= max_items[1] : y == 1); y *= 2){
+                    for(size_t z = 1; x*y*z <= max_size && (dim > 2 ? z <= max_items[2] : z == 1); z *= 2)
+                        result.push_back(size3(x, y, z));
+                }
+            }
+            return result;
+        }
+
+        /// Tune the work-group size of a built kernel.
+        /** Each candidate is executed once to warm up and then \a repeats
+            times on a profiling command queue. Candidates which fail to
+            launch are skipped. The kernel arguments must be set before
+            calling this function. The global size is padded to a multiple
+            of each candidate, so the kernel must ignore extra work-items.
+
+            \param context      The context of the kernel.
+            \param device       The device where the kernel is executed.
+            \param kernel       The kernel to be tuned.
+            \param dim          The number of dimensions.
+            \param global_size  The global size in each dimension.
+            \param local_sizes  Candidate work-group sizes. If it is empty,
+                                candidates() is used.
+            \param repeats      Number of timed executions per candidate.
+
+            \return             The fastest configuration, which is also
+                                recorded in this tuner.
+         */
+        Config tune(cl_context context, Device device, const Kernel& kernel, cl_uint dim, const size_t* global_size,
+                    const std::vector<size3>& local_sizes = std::vector<size3>(), int repeats = 5)
+        {
+            Config best;
+            best.time = std::numeric_limits<cl_ulong>::max();
+            measure(context, device, kernel, dim, global_size, local_sizes, repeats, best);
+            if(best.time == std::numeric_limits<cl_ulong>::max())
+                throw Error(CL_INVALID_WORK_GROUP_SIZE, __FILE__, __FUNCTION__, __LINE__);
+            record(kernel.name(), device.name().c_str(), dim, global_size, best);
+            return best;
+        }
+
+        /// Tune the compiler options and work-group size of a kernel.
+        /** The program is built once for every set of options, and the
+            work-group sizes of each built kernel are tuned as in the other
+            version of tune().
+
+            \param context      The context where programs are built.
+            \param device       The device where the kernel is executed.
+            \param source       The program source code.
+            \param kernel_name  The name of the kernel function.
+            \param options      Candidate sets of compiler options, e.g.
+                                "-DTILE=8" and "-DTILE=16".
+            \param bind         The function which sets the arguments of each
+                                built kernel.
+            \param dim          The number of dimensions.
+            \param global_size  The global size in each dimension.
+            \param local_sizes  Candidate work-group sizes. If it is empty,
+                                candidates() is used for each build.
+            \param repeats      Number of timed executions per candidate.
+
+            \return             The fastest configuration, which is also
+                                recorded in this tuner.
+         */
+        Config tune(cl_context context, Device device, const char* source, const char* kernel_name,
+                    const std::vector<std::string>& options, const std::function<void(Kernel&)>& bind,
+                    cl_uint dim, const size_t* global_size,
+                    const std::vector<size3>& local_sizes = std::vector<size3>(), int repeats = 5)
+        {
+            Config best;
+            best.time = std::numeric_limits<cl_ulong>::max();
+            for(size_t i = 0; i < options.size(); ++i){
+                cl_int err;
+                cl_program pid = clCreateProgramWithSource(context, 1, &source, NULL, &err);
+                CLPP_CHECK_ERROR(err);
+                Program p(pid);
+                try{
+                    p.build(device, options[i].c_str());
+                }catch(const Program::BuildError&){
+                    continue;
+                }
+                Kernel k = p.kernel(kernel_name);
+                bind(k);
+                Config c;
+                c.time = std::numeric_limits<cl_ulong>::max();
+                measure(context, device, k, dim, global_size, local_sizes, repeats, c);
+                if(c.time < best.time){
+                    best = c;
+                    best.options = options[i];
+                }
+            }
+            if(best.time == std::numeric_limits<cl_ulong>::max())
+                throw Error(CL_INVALID_WORK_GROUP_SIZE, __FILE__, __FUNCTION__, __LINE__);
+            record(kernel_name, device.name().c_str(), dim, global_size, best);
+            return best;
+        }
+
+        /// Save all tuned configurations to the file.
+        void save() const
+        {
+            std::lock_guard<std::mutex> lock(my_mutex);
+            std::ofstream fout(my_filename.c_str());
+            std::map<std::string, Config>::const_iterator i;
+            for(i = my_configs.begin(); i != my_configs.end(); ++i){
+                const Config& c = i->second;
+                fout << i->first << '\t'
+                     << c.local_size.s[0] << ' ' << c.local_size.s[1] << ' ' << c.local_size.s[2] << '\t'
+                     << c.time << '\t' << c.options << '\n';
+            }
+            if(!fout)
+                throw std::runtime_error("Failed to save tuned configurations to " + my_filename);
+        }
+
+    private:
+        // A key has three tab-separated fields: kernel name, device name
+        // and bucket.
+        // The key is built in one string, since it is looked up on every
+        // launch of a tuned kernel.
+        static std::string makeKey(const std::string& kernel_name, const std::string& device_name, cl_uint dim, const size_t* global_size)
+        {
+            std::string key;
+            key.reserve(kernel_name.size() + device_name.size() + 16);
+            key += kernel_name;
+            key += '\t';
+            key += device_name;
+            key += '\t';
+            appendBucket(key, dim, global_size);
+            return key;
+        }
+
+        static void appendBucket(std::string& s, cl_uint dim, const size_t* global_size)
+        {
+            for(cl_uint d = 0; d < dim; ++d){
+                size_t v = global_size[d];
+                int log = 0;
+                while(v > 1){
+                    v >>= 1;
+                    ++log;
+                }
+                if(d > 0)
+                    s += ',';
+                if(log >= 10)
+                    s += static_cast<char>('0' + log / 10);
+                s += static_cast<char>('0' + log % 10);
+            }
+        }
+
+        void load()
+        {
+            std::ifstream fin(my_filename.c_str());
+            std::string line;
+            while(std::getline(fin, line)){
+                // kernel, device, bucket, local size, time, options
+                std::vector<std::string> fields;
+                std::string::size_type begin = 0, end;
+                while(fields.size() < 5 && (end = line.find('\t', begin)) != std::string::npos){
+                    fields.push_back(line.substr(begin, end - begin));
+                    begin = end + 1;
+                }
+                fields.push_back(line.substr(begin));
+                if(fields.size() != 6)
+                    continue;
+
+                Config c;
+                std::istringstream local(fields[3]), time(fields[4]);
+                local >> c.local_size.s[0] >> c.local_size.s[1] >> c.local_size.s[2];
+                time >> c.time;
+                if(!local || !time)
+                    continue;
+                c.options = fields[5];
+                my_configs[fields[0] + '\t' + fields[1] + '\t' + fields[2]] = c;
+            }
+        }
+
+        void record(const std::string& kernel_name, const std::string& device_name, cl_uint dim, const size_t* global_size, const Config& config)
+        {
+            std::string key = makeKey(kernel_name, device_name, dim, global_size);
+            std::lock_guard<std::mutex> lock(my_mutex);
+            my_configs[key] = config;
+        }
+
+        static void measure(cl_context context, Device device, const Kernel& kernel, cl_uint dim, const size_t* global_size,
+                            std::vector<size3> local_sizes, int repeats, Config& best)
+        {
+            if(local_sizes.empty())
+                local_sizes = candidates(kernel, device, dim);
+
+            cl_int err;
+            cl_command_queue qid = clCreateCommandQueue(context, device.id(), CL_QUEUE_PROFILING_ENABLE, &err);
+            CLPP_CHECK_ERROR(err);
+            Resource<cl_command_queue> queue(qid);
+
+            for(size_t i = 0; i < local_sizes.size(); ++i){
+                const size_t* local = local_sizes[i].s;
+                size_t padded[3];
+                for(cl_uint d = 0; d < dim; ++d)
+                    padded[d] = (global_size[d] + local[d] - 1) / local[d] * local[d];
+
+                // Warm up, and skip candidates the kernel can't be launched with.
+                err = clEnqueueNDRangeKernel(qid, kernel.id(), dim, NULL, padded, local, 0, NULL, NULL);
+                if(err != CL_SUCCESS)
+                    continue;
+                CLPP_CHECK_ERROR(clFinish(qid));
+
+                cl_ulong fastest = std::numeric_limits<cl_ulong>::max();
+                for(int r = 0; r < repeats; ++r){
+                    cl_event eid;
+                    err = clEnqueueNDRangeKernel(qid, kernel.id(), dim, NULL, padded, local, 0, NULL, &eid);
+                    CLPP_CHECK_ERROR(err);
+                    Event e(eid);
+                    e.wait();
+                    fastest = std::min(fastest, e.getExecutionTime());
+                }
+
+                if(fastest < best.time){
+                    best.time = fastest;
+                    best.local_size = local_sizes[i];
+                    for(cl_uint d = dim; d < 3; ++d)
+                        best.local_size.s[d] = 1;
+                }
+            }
+        }
+
+        KernelTuner(const KernelTuner&);
+        KernelTuner& operator=(const KernelTuner&);
+
+        std::string my_filename;
+        mutable std::mutex my_mutex;
+        std::map<std::string, Config> my_configs;
+}; // class KernelTuner
+
+} // namespace clpp
+
+#endif // CLPP_TUNER_HPP
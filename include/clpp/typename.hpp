@@ -0,0 +1,64 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef CLPP_TYPENAME_HPP
+#define CLPP_TYPENAME_HPP
+
+#include "common.hpp"
+
+namespace clpp {
+
+/// The OpenCL C name of a host type.
+/** TypeName<T>::name() returns the name of the OpenCL C type which has the
+    same representation as \a T, e.g. \c "uint" for \c cl_uint and
+    \c "float4" for \c cl_float4, or NULL if \a T has no such type.
+
+    \c cl_half is not distinguished from \c cl_ushort, and 3-component
+    vectors are not distinguished from 4-component vectors, because they
+    are the same host types.
+ */
+template <typename T> struct TypeName {
+    /// Whether \a T has an OpenCL C name.
+    static const bool defined = false;
+
+    static const char* name()
+    {
+        return NULL;
+    }
+};
+
+#define CLPP_TYPE_NAME(type, str) \
+    template <> struct TypeName<type> { \
+        static const bool defined = true; \
+        static const char* name() \
+        { \
+            return str; \
+        } \
+    };
+
+#define CLPP_TYPE_NAMES(base) \
+    CLPP_TYPE_NAME(cl_##base, #base) \
+    CLPP_TYPE_NAME(cl_##base##2, #base "2") \
+    CLPP_TYPE_NAME(cl_##base##4, #base "4") \
+    CLPP_TYPE_NAME(cl_##base##8, #base "8") \
+    CLPP_TYPE_NAME(cl_##base##16, #base "16")
+
+CLPP_TYPE_NAMES(char)
+CLPP_TYPE_NAMES(uchar)
+CLPP_TYPE_NAMES(short)
+CLPP_TYPE_NAMES(ushort)
+CLPP_TYPE_NAMES(int)
+CLPP_TYPE_NAMES(uint)
+CLPP_TYPE_NAMES(long)
+CLPP_TYPE_NAMES(ulong)
+CLPP_TYPE_NAMES(float)
+CLPP_TYPE_NAMES(double)
+
+#undef CLPP_TYPE_NAMES
+#undef CLPP_TYPE_NAME
+
+} // namespace clpp
+
+#endif // CLPP_TYPENAME_HPP
@@ -0,0 +1,65 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This example builds programs without blocking the calling thread.
+int main()
+{
+    try{
+        string src =
+            "kernel void fill(global int* a, int value){"
+            "    a[get_global_id(0)] = value;"
+            "}";
+
+        Context context;
+        CommandQueue& q = context.queue();
+
+        // Build one program in the background.
+        future<Program> single = context.readProgramSourceAsync(src.c_str());
+
+        // Build several programs by a pool of threads. The last one does
+        // not compile.
+        vector<string> sources;
+        for(int i = 0; i < 4; ++i)
+            sources.push_back(src);
+        sources.push_back("kernel void broken(global int* a){ a[0] = ; }");
+        vector< future<Program> > programs = context.prebuild(sources);
+
+        Kernel k = single.get().kernel("fill");
+        Buffer<cl_int> buffer = context.createBuffer<cl_int>(16);
+        vector<cl_int> result(16);
+        for(size_t i = 0; i + 1 < programs.size(); ++i){
+            Kernel fill = programs[i].get().kernel("fill");
+            fill.setArgs(buffer, cl_int(i));
+            q.exec(fill, 16);
+            q.copy(buffer, &result[0]);
+            if(result[15] != cl_int(i)){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+
+        try{
+            programs.back().get();
+            cout << "FAILED" << endl;
+            return 1;
+        }catch(const Program::BuildError& err){
+            cout << "Build log of the broken program:" << endl << err.log() << endl;
+        }
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+const int LAUNCHES = 20000;
+
+// Enqueue LAUNCHES empty kernels and report the launch throughput.
+void Measure(const char* name, CommandQueue& q, const Kernel& k)
+{
+    q.finish();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for(int i = 0; i < LAUNCHES; ++i)
+        q.exec(k, 64);
+    q.finish();
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << name << ": " << LAUNCHES / elapsed.count() << " launches/s" << endl;
+}
+
+// This benchmark compares the launch throughput of commands enqueued with
+// and without event objects.
+int main()
+{
+    try{
+        string src = "kernel void nop(){}";
+
+        Context context;
+        Kernel k = context.readProgramSource(src.c_str()).kernel("nop");
+        CommandQueue q = context.queue();
+
+        Measure("With events   ", q, k);
+
+        q.disableEvents();
+        Measure("Without events", q, k);
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
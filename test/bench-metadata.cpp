@@ -0,0 +1,66 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+const int CALLS = 100000;
+const int TRANSFERS = 10000;
+
+template <typename F> double Measure(int n, F f)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(int i = 0; i < n; ++i)
+        f();
+    chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / n;
+}
+
+// This benchmark shows the host overhead removed by caching immutable
+// information of memory objects and devices in the wrapper classes.
+int main()
+{
+    try{
+        Context context;
+        CommandQueue& q = context.queue();
+        Device device = context.devices()[0];
+        Buffer<cl_float> buffer = context.createBuffer<cl_float>(4);
+        vector<cl_float> host(4, 1.0f);
+
+        volatile size_t sink = 0;
+
+        cout << "Buffer size:" << endl;
+        cout << "    queried:  " << Measure(CALLS, [&]{ sink = buffer.getInfo<size_t>(CL_MEM_SIZE) / sizeof(cl_float); }) << "ns" << endl;
+        cout << "    cached:   " << Measure(CALLS, [&]{ sink = buffer.size(); }) << "ns" << endl;
+
+        cout << "Maximum work-group size:" << endl;
+        cout << "    queried:  " << Measure(CALLS, [&]{ sink = device.getInfo<size_t>(CL_DEVICE_MAX_WORK_GROUP_SIZE); }) << "ns" << endl;
+        cout << "    cached:   " << Measure(CALLS, [&]{ sink = device.getMaxWorkGroupSize(); }) << "ns" << endl;
+
+        // A whole-buffer transfer used to query the size of the buffer
+        // before every write.
+        q.disableEvents();
+        cout << "Whole-buffer write of 16 bytes:" << endl;
+        cout << "    queried:  " << Measure(TRANSFERS, [&]{
+                q.copy(&host[0], buffer, 0, buffer.getInfo<size_t>(CL_MEM_SIZE) / sizeof(cl_float), CL_FALSE);
+            }) << "ns" << endl;
+        q.finish();
+        cout << "    cached:   " << Measure(TRANSFERS, [&]{ q.copy(&host[0], buffer, CL_FALSE); }) << "ns" << endl;
+        q.finish();
+        q.enableEvents();
+
+        (void)sink;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
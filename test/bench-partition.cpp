@@ -0,0 +1,103 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+const size_t N = 1 << 24;
+const int ITERATIONS = 20;
+
+const char* SOURCE =
+    "kernel void copy(global const float* a, global float* b){"
+    "    size_t i = get_global_id(0);"
+    "    b[i] = a[i];"
+    "}";
+
+// Copy N floats ITERATIONS times, split evenly over the devices of a
+// context with one command queue per device, and return the bandwidth in
+// GB/s.
+double MeasureCopy(Context& context)
+{
+    size_t num = context.devices().size();
+    size_t n = N / num;
+    Program program = context.readProgramSource(SOURCE);
+
+    // Kernels don't keep their buffers alive.
+    vector< Buffer<cl_float> > buffers;
+    vector<Kernel> kernels;
+    for(size_t d = 0; d < num; ++d){
+        buffers.push_back(context.createBuffer<cl_float>(n));
+        buffers.push_back(context.createBuffer<cl_float>(n));
+        Kernel k = program.createKernel("copy");
+        k.setArgs(buffers[2*d], buffers[2*d + 1]);
+        kernels.push_back(k);
+    }
+
+    // Warm up, so that pages are placed by the first kernel which touches
+    // them.
+    for(size_t d = 0; d < num; ++d)
+        context.queue(d).exec(kernels[d], n);
+    for(size_t d = 0; d < num; ++d)
+        context.queue(d).finish();
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(size_t d = 0; d < num; ++d){
+        context.queue(d).disableEvents();
+        for(int i = 0; i < ITERATIONS; ++i)
+            context.queue(d).exec(kernels[d], n);
+        context.queue(d).enableEvents();
+    }
+    for(size_t d = 0; d < num; ++d)
+        context.queue(d).finish();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    return 2.0 * sizeof(cl_float) * n * num * ITERATIONS / elapsed.count() / 1e9;
+}
+
+// This benchmark compares the memory bandwidth of a CPU device used as a
+// whole with the bandwidth of its sub-devices, one per NUMA node.
+int main()
+{
+    try{
+        DeviceList cpus(Platform(), CL_DEVICE_TYPE_CPU);
+        if(cpus.size() == 0){
+            cout << "No CPU device" << endl;
+            return 0;
+        }
+        Device cpu = cpus[0];
+
+        Context whole(cpu);
+        cout << "Whole device:        " << MeasureCopy(whole) << " GB/s" << endl;
+
+#ifdef CL_VERSION_1_2
+        const cl_device_affinity_domain domains[] = {
+            CL_DEVICE_AFFINITY_DOMAIN_NUMA,
+            CL_DEVICE_AFFINITY_DOMAIN_L3_CACHE
+        };
+        const char* names[] = { "NUMA node", "L3 cache" };
+        for(int i = 0; i < 2; ++i){
+            try{
+                Context parts(cpu, Partition::byAffinityDomain(domains[i]));
+                cout << "One per " << names[i] << " (" << parts.devices().size() << "): "
+                     << MeasureCopy(parts) << " GB/s" << endl;
+            }catch(const Error& err){
+                cout << "One per " << names[i] << ": not supported (" << err.code() << ")" << endl;
+            }
+        }
+#else
+        cout << "Sub-devices require OpenCL 1.2" << endl;
+#endif
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This is a short test showing how buffers are recycled by the buffer pool.
+int main()
+{
+    try{
+        Context context;
+        context.enableBufferPool();
+
+        for(int i = 0; i < 100; ++i){
+            // Buffers in the same size class are reused after the previous
+            // one has been destroyed, once the commands enqueued before are
+            // complete.
+            context.queue().finish();
+            Buffer<cl_float> buffer = context.createBuffer<cl_float>(1000 + i);
+            if(buffer.size() != 1000u + i){
+                cout << "Wrong buffer size: " << buffer.size() << endl;
+                return 1;
+            }
+        }
+
+        BufferPool::Statistics s = context.bufferPoolStatistics();
+        cout << "Hits:          " << s.hits << endl;
+        cout << "Misses:        " << s.misses << endl;
+        cout << "Pooled bytes:  " << s.pooled_bytes << endl;
+
+        if(s.misses != 1 || s.hits != 99){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        // Memory which may still be used by a command is not handed out.
+#ifdef CL_VERSION_1_1
+        {
+            vector<cl_float> host(1000);
+            cl_int err;
+            cl_event gate = clCreateUserEvent(context.id(), &err);
+            CLPP_CHECK_ERROR(err);
+            EventList wait((Event(gate)));
+
+            context.queue().finish();
+            Buffer<cl_float> a = context.createBuffer<cl_float>(1000);
+            cl_mem used = a.id();
+            context.queue().copy(&host[0], a, CL_FALSE, wait);
+            a = Buffer<cl_float>();
+
+            Buffer<cl_float> b = context.createBuffer<cl_float>(1000);
+            cl_mem other = b.id();
+            bool reused_in_flight = other == used;
+            b = Buffer<cl_float>();
+
+            CLPP_CHECK_ERROR(clSetUserEventStatus(gate, CL_COMPLETE));
+            context.queue().finish();
+            Buffer<cl_float> c = context.createBuffer<cl_float>(1000);
+            cout << "Reused in flight: " << reused_in_flight << endl;
+            // Both memory objects are free once the commands are complete.
+            if(reused_in_flight || (c.id() != used && c.id() != other)){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+#endif
+
+        // Empty buffers fail as they do without the pool.
+        try{
+            context.createBuffer<cl_float>(0);
+            cout << "FAILED" << endl;
+            return 1;
+        }catch(const Error& err){
+            if(err.code() != CL_INVALID_BUFFER_SIZE){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+        cout << "PASSED" << endl;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// Check that view holds the elements [first, first + count) of 0, 1, 2, ...
+static bool check(CommandQueue& q, const BufferView<cl_int>& view, cl_int first, cl_int step = 1)
+{
+    vector<cl_int> result(view.size());
+    q.copy(view, &result[0]);
+    for(size_t i = 0; i < result.size(); ++i)
+        if(result[i] != (first + cl_int(i)) * step)
+            return false;
+    return true;
+}
+
+// This is a test of buffer views backed by sub-buffers or offsets.
+int main()
+{
+    try{
+        string src =
+            "kernel void twice(global int* a, int base){"
+            "    a[base + get_global_id(0)] *= 2;"
+            "}";
+
+        const size_t n = 4096;
+
+        Context context;
+        Device device = context.devices()[0];
+        CommandQueue& q = context.queue();
+        Kernel k = context.readProgramSource(src.c_str()).kernel("twice");
+
+        vector<cl_int> host(n);
+        for(size_t i = 0; i < n; ++i)
+            host[i] = cl_int(i);
+        Buffer<cl_int> buffer = context.createBuffer<cl_int>(n);
+        q.copy(&host[0], buffer);
+
+        // An offset at the base address alignment gives a sub-buffer.
+        size_t unit = max<size_t>(device.getMemBaseAddrAlign() / 8 / sizeof(cl_int), 1);
+        size_t aligned = (1024 + unit - 1) / unit * unit;
+        BufferView<cl_int> sub = buffer.slice(aligned, 256, device);
+        cout << "Aligned view is a sub-buffer: " << sub.isSubBuffer() << endl;
+        if(sub.offset() != (sub.isSubBuffer() ? 0 : aligned) || !check(q, sub, cl_int(aligned))){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        // A misaligned offset falls back to the whole buffer and an offset.
+        BufferView<cl_int> offset = buffer.slice(1, 100, device);
+        if(offset.isSubBuffer() || offset.offset() != 1 || !check(q, offset, 1)){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        // Copies through a view only touch its range.
+        vector<cl_int> zeros(100, 0);
+        q.copy(&zeros[0], offset);
+        vector<cl_int> result(n);
+        q.copy(buffer, &result[0]);
+        if(result[0] != 0 || result[1] != 0 || result[100] != 0 || result[101] != 101){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+        q.copy(&host[0], buffer);
+
+        // Kernels see the view through its buffer and offset.
+        k.setArgs(sub, cl_int(sub.offset()));
+        q.exec(k, sub.size());
+        k.setArgs(offset, cl_int(offset.offset()));
+        q.exec(k, offset.size());
+        if(!check(q, sub, cl_int(aligned), 2) || !check(q, offset, 1, 2)){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        // Ranges outside the buffer are rejected up front.
+        for(int i = 0; i < 3; ++i){
+            try{
+                if(i == 0)
+                    buffer.slice(n - 10, 11);
+                else if(i == 1)
+                    buffer.slice(1, n, device);
+                else
+                    offset.slice(50, 51);
+                cout << "FAILED" << endl;
+                return 1;
+            }catch(const Error& err){
+                if(err.code() != CL_INVALID_VALUE){
+                    cout << "FAILED" << endl;
+                    return 1;
+                }
+            }
+        }
+
+        // A sub-buffer keeps pooled memory of its parent from being
+        // recycled.
+        context.enableBufferPool();
+        Buffer<cl_int> parent = context.createBuffer<cl_int>(n);
+        cl_mem parent_id = parent.id();
+        Buffer<cl_int> kept = parent.slice(0, 16).buffer();
+        parent = Buffer<cl_int>();
+        q.finish();
+        Buffer<cl_int> other = context.createBuffer<cl_int>(n);
+        if(other.id() == parent_id){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        cout << "PASSED" << endl;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
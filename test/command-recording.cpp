@@ -0,0 +1,87 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This example records a sequence of commands once and replays it with a
+// patched argument.
+int main()
+{
+    try{
+        string src =
+            "kernel void add(global int* a, int v){"
+            "    size_t i = get_global_id(0);"
+            "    a[i] += v;"
+            "}";
+
+        const size_t n = 1024;
+
+        Context context;
+        CommandQueue& queue = context.queue();
+        Program program = context.readProgramSource(src.c_str());
+        Kernel k = program.kernel("add");
+        Buffer<cl_int> a = context.createBuffer<cl_int>(n);
+        Buffer<cl_int> b = context.createBuffer<cl_int>(n);
+        vector<cl_int> input(n), output(n);
+        for(size_t i = 0; i < n; ++i)
+            input[i] = cl_int(i);
+
+        // Upload, add 1 and then v, copy to the other buffer and download.
+        CommandRecording recording(queue);
+        k.setArgs(a, cl_int(1));
+        recording.copy(&input[0], a);
+        recording.exec(k, n, 64);
+        size_t patched = recording.exec(k, n);
+        size_t copied = recording.copy(a, b);
+        recording.copy(b, &output[0]);
+
+        // Only recorded kernel executions can be patched.
+        size_t invalid[] = { copied, recording.size() };
+        for(size_t i = 0; i < 2; ++i){
+            try{
+                recording.setArg(invalid[i], 1, cl_int(0));
+                cout << "FAILED" << endl;
+                return 1;
+            }catch(const Error& err){
+                if(err.code() != CL_INVALID_VALUE){
+                    cout << "FAILED" << endl;
+                    return 1;
+                }
+            }
+        }
+
+        // Changing the original kernel doesn't affect the recording.
+        k.setArgs(b, cl_int(100));
+
+        for(cl_int v = 0; v < 3; ++v){
+            recording.setArg(patched, 1, v);
+            recording.replay().wait();
+            for(size_t i = 0; i < n; ++i){
+                if(output[i] != cl_int(i) + 1 + v){
+                    cout << "FAILED" << endl;
+                    return 1;
+                }
+            }
+        }
+
+        // A device-only recording may be replayed by a command buffer.
+        CommandRecording device_only(queue);
+        device_only.exec(k, n, 64);
+        device_only.replay(EventList(queue.marker())).wait();
+        cout << "command buffer: " << (device_only.usesCommandBuffer() ? "yes" : "no") << endl;
+
+        cout << "PASSED" << endl;
+    }
+    catch(Error& e){
+        cout << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
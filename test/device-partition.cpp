@@ -0,0 +1,92 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+#ifdef CL_VERSION_1_2
+// Compare a property list with the expected one, up to its terminating 0.
+bool SameProperties(const Partition& p, const cl_device_partition_property* expected, size_t n)
+{
+    for(size_t i = 0; i < n; ++i){
+        if(p.properties()[i] != expected[i])
+            return false;
+    }
+    return true;
+}
+
+// This is a test of partitioning a device into sub-devices.
+int main()
+{
+    try{
+        const cl_device_partition_property equally[] = { CL_DEVICE_PARTITION_EQUALLY, 2, 0 };
+        const cl_device_partition_property by_counts[] = { CL_DEVICE_PARTITION_BY_COUNTS, 3, 1, CL_DEVICE_PARTITION_BY_COUNTS_LIST_END, 0 };
+        vector<cl_uint> counts;
+        counts.push_back(3);
+        counts.push_back(1);
+        if(!SameProperties(Partition::equally(2), equally, 3) || !SameProperties(Partition::byCounts(counts), by_counts, 5)){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        Context context;
+        Device device = context.devices()[0];
+        cl_uint units = device.getMaxComputeUnits();
+        if(device.getPartitionMaxSubDevices() < 2 || units < 2){
+            cout << "The device cannot be partitioned." << endl;
+            cout << "PASSED" << endl;
+            return 0;
+        }
+
+        // Asking for more compute units than the device has must fail with
+        // an error, and leave the device usable.
+        try{
+            vector<cl_uint> too_many(2, units);
+            device.partition(Partition::byCounts(too_many));
+            cout << "FAILED" << endl;
+            return 1;
+        }catch(const Error& err){
+            if(err.code() != CL_DEVICE_PARTITION_FAILED && err.code() != CL_INVALID_DEVICE_PARTITION_COUNT
+                && err.code() != CL_INVALID_VALUE){
+                throw;
+            }
+            cout << "Partition failed as expected: " << err.what() << endl;
+        }
+
+        // A sub-device copied out of the list stays valid after the list is
+        // destroyed.
+        Device sub(NULL);
+        {
+            DeviceList subs = device.partition(Partition::equally(units / 2));
+            if(subs.size() < 2){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+            sub = subs[0];
+        }
+        if(sub.parent().id() != device.id() || sub.getMaxComputeUnits() != units / 2){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        cout << "PASSED" << endl;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
+#else
+int main()
+{
+    cout << "PASSED" << endl;
+    return 0;
+}
+#endif
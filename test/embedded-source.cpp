@@ -0,0 +1,70 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// fill.hpp is generated from fill.cl by
+//     lua tools/embedcl.lua -n test fill.cl > fill.hpp
+// fill.cl has a comment with characters which must be escaped.
+#include "fill.hpp"
+
+// The contents of fill.cl, written by hand.
+static const char expected[] =
+    "// Escaping test: \"quotes\", a back\\slash, the trigraph ?" "?= and a\ttab, \xc3\xbcnic\xc3\xb6" "de.\n"
+    "kernel void fill(global int* a, int value){\n"
+    "    a[get_global_id(0)] = value;\n"
+    "}\n";
+
+// This example builds a program from an embedded source.
+int main()
+{
+    try{
+        const EmbeddedSource& fill_cl = EmbeddedSources::get("fill.cl");
+        if(fill_cl.size != sizeof(expected) - 1
+            || string(fill_cl.source, fill_cl.size) != expected
+            || fill_cl.hash != Fnv1a64(expected, sizeof(expected) - 1)){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        Context context;
+        CommandQueue& q = context.queue();
+        context.enableProgramCache(".");
+
+        // Built twice, the second build is served by the program cache
+        // with the hash from the table.
+        context.readProgramSource(fill_cl);
+        Kernel k = context.readProgramSource(fill_cl).kernel("fill");
+
+        Buffer<cl_int> buffer = context.createBuffer<cl_int>(16);
+        k.setArgs(buffer, cl_int(7));
+        q.exec(k, 16);
+        vector<cl_int> result(16);
+        q.copy(buffer, &result[0]);
+
+        if(result[15] != 7 || context.programCacheStatistics().hits == 0){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        try{
+            EmbeddedSources::get("missing.cl");
+            cout << "FAILED" << endl;
+            return 1;
+        }catch(const EmbeddedSources::NotFound& err){
+            cout << err.what() << endl;
+        }
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -3,7 +3,11 @@
 //    (See accompanying file LICENSE_1_0.txt or copy at
 //          http://www.boost.org/LICENSE_1_0.txt)
 
+#include <atomic>
+#include <future>
 #include <iostream>
+#include <thread>
+#include <vector>
 #include <clpp/clpp.hpp>
 
 using namespace std;
@@ -29,6 +33,36 @@ int main()
         e.wait(); // Wait until this command has been finished.
         cout << "Total execution time: " << e.getExecutionTime() << "ns" << endl;
 
+        // Commands can wait for a list of events, which may come from other
+        // command queues in the same context.
+        EventList deps;
+        deps.append(q.exec(k, 4096));
+        deps.append(q.exec(k, 4096));
+        Event m = q.marker(deps);
+        m.wait();
+        cout << "Marker after two kernels: " << (m.status() == CL_COMPLETE ? "complete" : "not complete") << endl;
+
+        // Completion can be observed without blocking a thread per command,
+        // by a callback or a future.
+        atomic<int> completed(0);
+        vector<future<void> > futures;
+        for(int i = 0; i < 8; ++i){
+            Event e = q.exec(k, 4096);
+            e.then([&completed](cl_int status){
+                if(status == CL_COMPLETE)
+                    ++completed;
+            });
+            futures.push_back(e.toFuture());
+        }
+        q.flush();
+        for(size_t i = 0; i < futures.size(); ++i)
+            futures[i].get();
+
+        // Callbacks of the same event may be called in any order.
+        while(completed < 8)
+            this_thread::yield();
+        cout << "Callbacks after eight kernels: " << completed << endl;
+
     }catch(const Error& err){
         cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
         return 1;
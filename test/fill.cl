@@ -0,0 +1,4 @@
+// Escaping test: "quotes", a back\slash, the trigraph ??= and a	tab, ünicöde.
+kernel void fill(global int* a, int value){
+    a[get_global_id(0)] = value;
+}
@@ -0,0 +1,34 @@
+#ifndef CLPP_EMBEDDED_TEST_HPP
+#define CLPP_EMBEDDED_TEST_HPP
+
+/* This file is generated by embedcl.lua automatically.
+ * DO NOT MODIFY THIS FILE DIRECTLY.
+ * Please edit the sources below and re-generate this file for modification.
+ *
+ *   fill.cl
+ */
+
+#include <clpp/embedded.hpp>
+
+namespace clpp {
+namespace embedded {
+namespace test {
+
+// fill.cl
+constexpr char source0[] =
+    "// Escaping test: \"quotes\", a back\\slash, the trigraph \?\?= and a\ttab, \303\274nic\303\266de.\n"
+    "kernel void fill(global int* a, int value){\n"
+    "    a[get_global_id(0)] = value;\n"
+    "}\n";
+
+constexpr EmbeddedSource sources[] = {
+    { "fill.cl", source0, 160, 0x430a3ad4a4daa480ULL },
+};
+
+static const EmbeddedSourceRegistrar registrar(sources, 1);
+
+} // namespace test
+} // namespace embedded
+} // namespace clpp
+
+#endif // CLPP_EMBEDDED_TEST_HPP
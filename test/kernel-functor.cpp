@@ -0,0 +1,63 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This example launches a kernel through a functor with a declared signature.
+int main()
+{
+    try{
+        string src =
+            "kernel void saxpy(global const float* x, global float* y, float a, uint n){"
+            "    size_t i = get_global_id(0);"
+            "    if(i < n)"
+            "        y[i] += a * x[i];"
+            "}";
+
+        const size_t n = 1000;
+
+        Context context;
+        CommandQueue& q = context.queue();
+        Program program = context.readProgramSource(src.c_str(), "-cl-kernel-arg-info");
+
+        vector<cl_float> x(n, 1.0f), y(n, 2.0f);
+        Buffer<cl_float> bx = context.createBuffer<cl_float>(n, CL_MEM_READ_ONLY);
+        Buffer<cl_float> by = context.createBuffer<cl_float>(n);
+        q.copy(&x[0], bx);
+        q.copy(&y[0], by);
+
+        KernelFunctor<Buffer<cl_float>, Buffer<cl_float>, cl_float, cl_uint> saxpy(program, "saxpy");
+        Event e = saxpy(q, NDRange(1024, 64), bx, by, 3.0f, cl_uint(n));
+        saxpy(q, NDRange(1024, 64), EventList(e), bx, by, 1.0f, cl_uint(n));
+
+        q.copy(by, &y[0]);
+        for(size_t i = 0; i < n; ++i){
+            if(y[i] != 6.0f){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+        cout << "y = " << y[0] << endl;
+
+        // A signature with the wrong number of arguments is rejected.
+        try{
+            KernelFunctor<Buffer<cl_float>, cl_float> wrong(program, "saxpy");
+            cout << "FAILED" << endl;
+            return 1;
+        }catch(const Kernel::ArgumentError& err){
+            cout << err.what() << endl;
+        }
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This is a test of tuned work-group sizes which are saved, reloaded and
+// used by CommandQueue::exec.
+int main()
+{
+    const char* filename = "kernel-tuner-test.txt";
+    std::remove(filename);
+    try{
+        string src =
+            "kernel void groups(global int* a){"
+            "    a[get_global_id(0)] = get_local_size(0);"
+            "}";
+
+        const size_t n = 1024;
+
+        Context context;
+        Device device = context.devices()[0];
+        Program program = context.readProgramSource(src.c_str());
+        Kernel k = program.kernel("groups");
+        Buffer<cl_int> buffer = context.createBuffer<cl_int>(n);
+        k.setArgs(buffer);
+
+        // Tune with a single candidate, so the result is known.
+        size_t tuned = min<size_t>(16, k.workGroupInfo(device).work_group_size);
+        {
+            KernelTuner tuner(filename);
+            vector<size3> candidates(1, size3(tuned, 1, 1));
+            tuner.tune(context.id(), device, k, 1, &n, candidates);
+            tuner.save();
+        }
+
+        // A new tuner loads the saved size, and exec uses it when no
+        // work-group size is given.
+        shared_ptr<const KernelTuner> loaded(new KernelTuner(filename));
+        KernelTuner::Config config;
+        if(!loaded->lookup(k.name(), device.name().c_str(), 1, &n, config) || config.local_size.s[0] != tuned){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        CommandQueue& q = context.queue();
+        q.setTuner(loaded);
+        q.exec(k, n);
+        vector<cl_int> result(n);
+        q.copy(buffer, &result[0]);
+        cout << "Tuned work-group size: " << tuned << ", used: " << result[0] << endl;
+        std::remove(filename);
+        if(result[0] != cl_int(tuned) || result[n - 1] != cl_int(tuned)){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+        cout << "PASSED" << endl;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        std::remove(filename);
+        return 1;
+    }
+    return 0;
+}
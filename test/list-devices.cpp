@@ -1,6 +1,7 @@
 #include <iostream>
 #include <iomanip>
 #include <exception>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <clpp/clpp.hpp>
@@ -23,40 +24,61 @@ void ListPlatformInfo(Platform p, size_t ind = 0)
     cout << indent << "Extensions: " << p.extensions() << endl;
 }
 
-void ListDeviceInfo(Device d, size_t ind = 0)
+void ListDeviceInfo(const DeviceInfo& d, size_t ind = 0)
 {
     string indent(ind, ' ');
 
-    cout << indent << "Vendor:                   " << d.vendor() << endl;
-    cout << indent << "Available:                " << YesNo( d.available() ) << endl;
-    cout << indent << "Compiler:                 " << YesNo( d.hasCompiler() ) << endl;
-    cout << indent << "Error correction:         " << YesNo( d.hasErrorCorrection() ) << endl;
-    cout << indent << "Image support:            " << YesNo( d.hasImageSupport() ) << endl;
-    cout << indent << "Native kernel support:    " << YesNo( d.hasNativeKernelSupport() ) << endl;
+    cout << indent << "Vendor:                   " << d.vendor << endl;
+    cout << indent << "Version:                  " << d.version << endl;
+    cout << indent << "Driver version:           " << d.driver_version << endl;
+    cout << indent << "Available:                " << YesNo( d.available ) << endl;
+    cout << indent << "Compiler:                 " << YesNo( d.compiler ) << endl;
+    cout << indent << "Error correction:         " << YesNo( d.error_correction ) << endl;
+    cout << indent << "Image support:            " << YesNo( d.image_support ) << endl;
+    cout << indent << "Native kernel support:    " << YesNo( (d.execution_capabilities & CL_EXEC_NATIVE_KERNEL) != 0 ) << endl;
+    cout << indent << "Out-of-order execution:   " << YesNo( (d.queue_properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) != 0 ) << endl;
+    cout << indent << "Profiling:                " << YesNo( (d.queue_properties & CL_QUEUE_PROFILING_ENABLE) != 0 ) << endl;
 
-    size2 m2d = d.getImage2DMaxSize();
-    size3 m3d = d.getImage3DMaxSize();
+    cout << indent << "Maximum size of 2D image: " << d.image2d_max_size.s[0] << 'x' << d.image2d_max_size.s[1] << endl;
+    cout << indent << "Maximum size of 3D image: " << d.image3d_max_size.s[0] << 'x' << d.image3d_max_size.s[1] << 'x' << d.image3d_max_size.s[2] << endl;
 
-    cout << indent << "Maximum size of 2D image: " << m2d.s[0] << 'x' << m2d.s[1] << endl;
-    cout << indent << "Maximum size of 3D image: " << m3d.s[0] << 'x' << m3d.s[1] << 'x' << m3d.s[2] << endl;
+    cout << indent << "Number of compute units:  " << d.max_compute_units << endl;
+    cout << indent << "Clock frequency:          " << d.max_clock_frequency << endl;
+    cout << indent << "Global memory size:       " << d.global_mem_size << endl;
+    cout << indent << "Global memory cache size: " << d.global_mem_cache_size << endl;
+    cout << indent << "Cache line size:          " << d.global_mem_cacheline_size << endl;
+    cout << indent << "Local memory size:        " << d.local_mem_size << endl;
+    cout << indent << "Constant buffer size:     " << d.max_constant_buffer_size << endl;
+    cout << indent << "Maximum allocatable size: " << d.max_mem_alloc_size << endl;
+    cout << indent << "Maximum parameter size:   " << d.max_parameter_size << endl;
 
-    cout << indent << "Number of compute units:  " << d.getMaxComputeUnits() << endl;
-    cout << indent << "Clock frequency:          " << d.getMaxClockFrequency() << endl;
-    cout << indent << "Global memory size:       " << d.getGlobalMemSize() << endl;
-    cout << indent << "Local memory size:        " << d.getLocalMemSize() << endl;
-    cout << indent << "Maximum allocatable size: " << d.getMaxMemAllocSize() << endl;
-    cout << indent << "Maximum parameter size:   " << d.getMaxParameterSize() << endl;
+    cout << indent << "Preferred vector widths:  "
+         << "char" << d.preferred_vector_width_char << ' '
+         << "short" << d.preferred_vector_width_short << ' '
+         << "int" << d.preferred_vector_width_int << ' '
+         << "long" << d.preferred_vector_width_long << ' '
+         << "float" << d.preferred_vector_width_float << ' '
+         << "double" << d.preferred_vector_width_double << endl;
 
-    cout << indent << "Maximum work-group size:  " << d.getMaxWorkGroupSize() << endl;
+    cout << indent << "Maximum work-group size:  " << d.max_work_group_size << endl;
 
-    // We currently don't implement an interface to retrieve maximum work-item size.
-    vector<size_t> max_work_size = d.getMaxWorkItemSizes();
+    const vector<size_t>& max_work_size = d.max_work_item_sizes;
     cout << indent << "Maximum work-item sizes:  " << max_work_size[0];
     for(size_t i = 1; i < max_work_size.size(); ++i)
         cout << 'x' << max_work_size[i];
     cout << endl;
 }
 
+// A snapshot must survive a round trip through a stream.
+bool CheckSerialization(const DeviceInfo& info)
+{
+    stringstream s;
+    s << info;
+    DeviceInfo loaded;
+    s >> loaded;
+    return s && loaded == info;
+}
+
 int main()
 {
     try{
@@ -74,9 +96,14 @@ int main()
 
             DeviceList device_list(p, CL_DEVICE_TYPE_ALL);
             for(size_t j = 0; j < device_list.size(); ++j){
-                Device d = device_list[j];
-                cout << setw(2) << j+1 << ". " << d.name() << endl;
-                ListDeviceInfo(d, 4);
+                DeviceInfo info = device_list[j].info();
+                cout << setw(2) << j+1 << ". " << info.name << endl;
+                ListDeviceInfo(info, 4);
+
+                if(!CheckSerialization(info)){
+                    cout << "FAILED: the device information can't be read back" << endl;
+                    return 1;
+                }
             }
 
         }
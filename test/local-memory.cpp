@@ -0,0 +1,74 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This example sums an array by a work-group reduction in local memory.
+int main()
+{
+    try{
+        string src =
+            "kernel void reduce(global const float* in, global float* out, local float* scratch){"
+            "    size_t l = get_local_id(0);"
+            "    scratch[l] = in[get_global_id(0)];"
+            "    barrier(CLK_LOCAL_MEM_FENCE);"
+            "    for(size_t s = get_local_size(0) / 2; s > 0; s /= 2){"
+            "        if(l < s)"
+            "            scratch[l] += scratch[l + s];"
+            "        barrier(CLK_LOCAL_MEM_FENCE);"
+            "    }"
+            "    if(l == 0)"
+            "        out[get_group_id(0)] = scratch[0];"
+            "}";
+
+        const size_t local_size = 64;
+        const size_t groups = 16;
+        const size_t n = local_size * groups;
+
+        Context context;
+        CommandQueue& q = context.queue();
+        Kernel k = context.readProgramSource(src.c_str()).kernel("reduce");
+
+        vector<cl_float> input(n, 1.0f);
+        Buffer<cl_float> in = context.createBuffer<cl_float>(n, CL_MEM_READ_ONLY);
+        Buffer<cl_float> out = context.createBuffer<cl_float>(groups, CL_MEM_WRITE_ONLY);
+        q.copy(&input[0], in);
+
+        k.setArgs(in, out, LocalMemory<cl_float>(local_size));
+        q.exec(k, n, local_size);
+
+        vector<cl_float> sums(groups);
+        q.copy(out, &sums[0]);
+        for(size_t i = 0; i < groups; ++i){
+            if(sums[i] != local_size){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+        cout << "Sum of each work-group: " << sums[0] << endl;
+
+        // Asking for more local memory than the device has is reported
+        // before the kernel is launched.
+        cl_ulong available = q.device().getLocalMemSize();
+        k.setArg(2, LocalMemory<cl_float>(static_cast<size_t>(available / sizeof(cl_float)) + 1));
+        try{
+            q.exec(k, n, local_size);
+            cout << "FAILED" << endl;
+            return 1;
+        }catch(const Kernel::LocalMemoryError& err){
+            cout << err.what() << endl;
+        }
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This is a test of the automatic choice of work-group sizes.
+int main()
+{
+    try{
+        string src =
+            "kernel void fill(global int* a, int n){"
+            "    size_t i = get_global_id(0);"
+            "    if(i < n)"
+            "        a[i] = i;"
+            "}"
+            "kernel __attribute__((reqd_work_group_size(8, 4, 1))) void fixed(global int* a){"
+            "    a[get_global_id(1) * get_global_size(0) + get_global_id(0)] = 1;"
+            "}";
+
+        Context context;
+        Device device = context.devices()[0];
+        CommandQueue& q = context.queue();
+        Program program = context.readProgramSource(src.c_str());
+
+        // Global sizes are padded to whole work-groups.
+        if(CommandQueue::padSize(10, 4) != 12 || CommandQueue::padSize(12, 4) != 12
+           || CommandQueue::padSize(0, 4) != 0 || CommandQueue::padSize(1, 1) != 1){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        // reqd_work_group_size is always used.
+        Kernel fixed = program.kernel("fixed");
+        size_t global2[2] = { 100, 100 }, local2[2] = { 0, 0 };
+        fixed.selectLocalSize(device, 2, global2, local2);
+        cout << "Required size: " << local2[0] << "x" << local2[1] << endl;
+        if(local2[0] != 8 || local2[1] != 4){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        // Otherwise the first dimension is a multiple of the preferred
+        // multiple, within the limits of the kernel.
+        Kernel fill = program.kernel("fill");
+        Kernel::WorkGroupInfo info = fill.workGroupInfo(device);
+        size_t multiple = info.preferred_work_group_size_multiple;
+        const size_t sizes[] = { 1, 3, 100, 1000, 100000 };
+        for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i){
+            size_t global = sizes[i], local = 0, again = 0;
+            fill.selectLocalSize(device, 1, &global, &local);
+            fill.selectLocalSize(device, 1, &global, &again);
+            cout << "Global size " << global << ": work-group size " << local << endl;
+            bool whole = multiple <= 1 || multiple > info.work_group_size || local % multiple == 0;
+            if(local == 0 || local > info.work_group_size || !whole || again != local){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+
+        // execAuto pads the global size, and the kernel ignores the rest.
+        const size_t n = 1001;
+        Buffer<cl_int> buffer = context.createBuffer<cl_int>(n);
+        fill.setArgs(buffer, cl_int(n));
+        q.execAuto(fill, n);
+        vector<cl_int> result(n);
+        q.copy(buffer, &result[0]);
+        for(size_t i = 0; i < n; ++i){
+            if(result[i] != cl_int(i)){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+        cout << "PASSED" << endl;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
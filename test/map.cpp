@@ -0,0 +1,70 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <string>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This is a short example showing how a buffer object can be accessed by
+// mapping it into the host address space.
+int main()
+{
+    try{
+        string src =
+            "kernel void square(global int* output){"
+            "    int i = get_global_id(0);"
+            "    output[i] = i*i;"
+            "}";
+
+        Context context;
+        Kernel k = context.readProgramSource(src.c_str()).kernel("square");
+
+        // Buffers allocated in host accessible memory can be mapped without
+        // copying on most devices.
+        Buffer<cl_int> output = context.createBuffer<cl_int>(1024, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR);
+        k.setArgs(output);
+
+        CommandQueue& q = context.queue();
+        q.exec(k, 1024);
+
+        // The buffer is unmapped when the mapped range is destroyed.
+        bool failed = false;
+        {
+            MappedRange<cl_int> data = q.map(output, 0, 16, CL_MAP_READ);
+            int i = 0;
+            for(MappedRange<cl_int>::Iterator p = data.begin(); p != data.end(); ++p, ++i)
+                if(*p != i*i)
+                    failed = true;
+        }
+
+        // A range is mapped for reading and writing by default.
+        {
+            MappedRange<cl_int> data = q.map(output, 1000, 24);
+            if(data[0] != 1000*1000 || data.size() != 24)
+                failed = true;
+            data[0] = -1;
+        }
+
+        // A whole buffer is mapped by mapAll.
+        {
+            MappedRange<cl_int> data = q.mapAll(output, CL_MAP_READ);
+            if(data.size() != 1024 || data[1000] != -1 || data[1023] != 1023*1023)
+                failed = true;
+        }
+        q.finish();
+
+        cout << "Checking the answer..." << (failed ? "FAILED" : "PASSED") << endl;
+        if(failed)
+            return 1;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
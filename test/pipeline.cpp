@@ -0,0 +1,63 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// Bind the kernel arguments of a chunk and return its global size.
+size_t Bind(Kernel& k, const Buffer<cl_float>& in, const Buffer<cl_float>& out, size_t count)
+{
+    k.setArgs(in, out, cl_uint(count));
+    return count;
+}
+
+// This is a short example showing how a host array is streamed through the
+// device in chunks, overlapping transfers with computation.
+int main()
+{
+    try{
+        string src =
+            "kernel void square(global const float* in, global float* out, uint n){"
+            "    uint i = get_global_id(0);"
+            "    if(i < n)"
+            "        out[i] = in[i]*in[i];"
+            "}";
+
+        Context context;
+        Kernel k = context.readProgramSource(src.c_str()).kernel("square");
+
+        const size_t n = 4 << 20;
+        vector<cl_float> input(n), output(n);
+        for(size_t i = 0; i < n; ++i)
+            input[i] = cl_float(i % 1024);
+
+        // Rotate three pairs of 256K-element buffers over the array.
+        StreamPipeline<cl_float> pipeline(context, k, 256 << 10, 3);
+        StreamPipeline<cl_float>::Statistics s = pipeline.run(&input[0], &output[0], n, Bind);
+
+        cout << "Chunks:        " << s.chunks << endl;
+        cout << "Throughput:    " << s.throughput / (1 << 20) << "MB/s" << endl;
+        cout << "Overlap:       " << s.overlap << endl;
+
+        cout << "Checking the answer..." << flush;
+        for(size_t i = 0; i < n; ++i){
+            if(output[i] != input[i]*input[i]){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+        cout << "PASSED" << endl;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
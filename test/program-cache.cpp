@@ -0,0 +1,111 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// Create an empty directory for the cache of this test, so that runs never
+// share entries.
+string MakeTempDir()
+{
+#ifdef _WIN32
+    char name[L_tmpnam];
+    if(!std::tmpnam(name) || _mkdir(name) != 0)
+        return string();
+    return name;
+#else
+    const char* base = getenv("TMPDIR");
+    string pattern = string(base && *base ? base : "/tmp") + "/clpp-program-cache-XXXXXX";
+    vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    if(!mkdtemp(&name[0]))
+        return string();
+    return &name[0];
+#endif
+}
+
+// Remove the directory made by MakeTempDir and the entries in it.
+void RemoveDir(const string& dir)
+{
+#ifdef _WIN32
+    _finddata_t data;
+    intptr_t h = _findfirst((dir + "\\*").c_str(), &data);
+    if(h != -1){
+        do{
+            std::remove((dir + "\\" + data.name).c_str());
+        }while(_findnext(h, &data) == 0);
+        _findclose(h);
+    }
+    _rmdir(dir.c_str());
+#else
+    if(DIR* d = opendir(dir.c_str())){
+        while(dirent* e = readdir(d))
+            std::remove((dir + "/" + e->d_name).c_str());
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+#endif
+}
+
+// This is a short test showing how program binaries are reused by the
+// program cache.
+int main()
+{
+    string dir = MakeTempDir();
+    if(dir.empty()){
+        cerr << "Cannot create a temporary directory" << endl;
+        return 1;
+    }
+
+    try{
+        string src =
+            "kernel void square(global int* output){"
+            "    int i = get_global_id(0);"
+            "    output[i] = i*i;"
+            "}";
+
+        Context context;
+        context.enableProgramCache(dir);
+
+        // The cache is empty, so the first build compiles the program, and
+        // the second one must be served by the cache.
+        context.readProgramSource(src.c_str(), "-DCLPP_PROGRAM_CACHE_TEST");
+        Kernel k = context.readProgramSource(src.c_str(), "-DCLPP_PROGRAM_CACHE_TEST").kernel("square");
+
+        ProgramCache::Statistics s = context.programCacheStatistics();
+        cout << "Hits:          " << s.hits << endl;
+        cout << "Misses:        " << s.misses << endl;
+        cout << "Stale entries: " << s.stale << endl;
+        cout << "Compile time:  " << s.compile_time << "ns" << endl;
+        cout << "Load time:     " << s.load_time << "ns" << endl;
+
+        RemoveDir(dir);
+        if(s.misses != 1 || s.hits != 1){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+        cout << "PASSED" << endl;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        RemoveDir(dir);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This example shows how kernel objects are reused by a program.
+int main()
+{
+    try{
+        string src =
+            "kernel void first(global int* a){ a[0] = 1; }"
+            "kernel void second(global int* a){ a[0] = 2; }";
+
+        Context context;
+        Program program = context.readProgramSource(src.c_str());
+
+        // Every call gives an independent kernel object with its own
+        // arguments.
+        Kernel a = program.kernel("first");
+        Kernel b = program.kernel("first");
+        cl_kernel released = b.id();
+
+        // A released kernel object is handed out again.
+        b = Kernel();
+        Kernel c = program.kernel("first");
+
+        // Warm up the cache with all kernels at once.
+        size_t count = program.kernels().size();
+        cl_kernel warm = program.kernel("second").id();
+        Kernel d = program.kernel("second");
+
+        cout << "Kernels in program: " << count << endl;
+        if(a.id() == released || c.id() != released || count != 2 || d.id() != warm){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This example builds variants of a program specialized by -D options.
+int main()
+{
+    try{
+        string src =
+            "kernel void scale(global TYPE* a){"
+            "    a[get_global_id(0)] *= (TYPE)(FACTOR);"
+            "}";
+
+        Context context;
+        CommandQueue& q = context.queue();
+        ProgramTemplate scale(context, src);
+
+        typedef ProgramTemplate::Parameters Parameters;
+        Parameters ints = Parameters().type<cl_int>("TYPE").value("FACTOR", 3);
+        Parameters floats = Parameters().value("FACTOR", 0.5f).type<cl_float>("TYPE");
+        cout << "Options: " << scale.options(ints) << endl;
+        cout << "Options: " << scale.options(floats) << endl;
+
+        // The options don't depend on the order of the parameters.
+        if(scale.options(ints) != scale.options(Parameters().value("FACTOR", 3).type<cl_int>("TYPE"))){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        vector<Parameters> variants;
+        variants.push_back(ints);
+        variants.push_back(floats);
+        scale.prebuild(variants);
+
+        vector<cl_int> a(16, 2);
+        Buffer<cl_int> ba = context.createBuffer<cl_int>(a.size());
+        q.copy(&a[0], ba);
+        Kernel ki = scale.get(ints).kernel("scale");
+        ki.setArgs(ba);
+        q.exec(ki, a.size());
+        q.copy(ba, &a[0]);
+
+        vector<cl_float> b(16, 2.0f);
+        Buffer<cl_float> bb = context.createBuffer<cl_float>(b.size());
+        q.copy(&b[0], bb);
+        Kernel kf = scale.get(floats).kernel("scale");
+        kf.setArgs(bb);
+        q.exec(kf, b.size());
+        q.copy(bb, &b[0]);
+
+        // The same variant is not built again.
+        Program again = scale.get(Parameters().type<cl_int>("TYPE").value("FACTOR", 3));
+
+        cout << "a = " << a[0] << ", b = " << b[0] << ", variants = " << scale.size() << endl;
+        if(a[15] != 6 || b[15] != 1.0f || scale.size() != 2 || again.id() != scale.get(ints).id()){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+static bool equal(const vector<size_t>& parts, size_t a, size_t b, size_t c = size_t(-1))
+{
+    vector<size_t> expected;
+    expected.push_back(a);
+    expected.push_back(b);
+    if(c != size_t(-1))
+        expected.push_back(c);
+    return parts == expected;
+}
+
+// This example splits a kernel execution over all devices of a platform.
+int main()
+{
+    try{
+        // Parts follow the throughput of each device, in whole units of
+        // the granularity, and end at the end of the range.
+        vector<double> rates;
+        rates.push_back(1);
+        rates.push_back(3);
+        bool proportional = equal(SplitLauncher::partition(rates, 1000, 10), 250, 750)
+                         && equal(SplitLauncher::partition(rates, 95, 10), 30, 65);
+        rates.push_back(0);
+        proportional = proportional && equal(SplitLauncher::partition(rates, 64), 16, 48, 0);
+        rates.assign(3, 2.5);
+        proportional = proportional && equal(SplitLauncher::partition(rates, 100), 34, 33, 33);
+        if(!proportional){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        // Each part writes only its own slice of the output, indexed from
+        // the global offset of the part.
+        string src =
+            "kernel void index(global int* a, int base){"
+            "    size_t i = get_global_id(0);"
+            "    a[i - get_global_offset(0) + base] = i;"
+            "}"
+            "kernel void index2(global int* a, int width, int base){"
+            "    size_t row = get_global_id(1) - get_global_offset(1);"
+            "    a[row * width + get_global_id(0) + base] = get_global_id(1) * width + get_global_id(0);"
+            "}";
+
+        const size_t width = 64, height = 64, n = width * height;
+
+        Context context(Platform(), CL_DEVICE_TYPE_ALL);
+        Program program = context.readProgramSource(src.c_str());
+        Buffer<cl_int> buffer = context.createBuffer<cl_int>(n);
+        vector<cl_int> result(n);
+
+        SplitLauncher launcher(context, program.kernel("index"));
+        vector< BufferView<cl_int> > slices(launcher.size());
+        for(int run = 0; run < 3; ++run){
+            vector<cl_int> zeros(n, 0);
+            context.queue().copy(&zeros[0], buffer);
+            launcher.exec(n, 64, [&](Kernel& k, const Split& s){
+                slices[s.index] = s.slice(buffer);
+                k.setArgs(slices[s.index], cl_int(slices[s.index].offset()));
+            }).wait();
+
+            // The parts are combined in the whole buffer.
+            context.queue().copy(buffer, &result[0]);
+            for(size_t i = 0; i < n; ++i){
+                if(result[i] != cl_int(i)){
+                    cout << "FAILED" << endl;
+                    return 1;
+                }
+            }
+        }
+
+        vector<double> measured = launcher.throughput();
+        vector<size_t> parts = launcher.partition(n, 64);
+        for(size_t d = 0; d < launcher.size(); ++d)
+            cout << context.devices()[d].name() << ": " << measured[d] << " work-items/s, next part " << parts[d] << endl;
+
+        // A 2-D range is split into bands of rows.
+        SplitLauncher launcher2(context, program.kernel("index2"));
+        vector< BufferView<cl_int> > bands(launcher2.size());
+        bool whole_rows = true;
+        launcher2.exec(size2(width, height), size2(16, 4), [&](Kernel& k, const Split& s){
+            whole_rows = whole_rows && s.offset.s[0] == 0 && s.size.s[0] == width;
+            bands[s.index] = s.slice(buffer);
+            k.setArgs(bands[s.index], cl_int(width), cl_int(bands[s.index].offset()));
+        }).wait();
+        context.queue().copy(buffer, &result[0]);
+        for(size_t i = 0; i < n; ++i){
+            if(!whole_rows || result[i] != cl_int(i)){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
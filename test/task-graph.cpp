@@ -0,0 +1,110 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+// This example runs a small graph of copies, kernels and a host function
+// with partial dependencies on several command queues.
+int main()
+{
+    try{
+        string src =
+            "kernel void scale(global float* a, float f){"
+            "    a[get_global_id(0)] *= f;"
+            "}"
+            "kernel void add(global const float* a, global const float* b, global float* c){"
+            "    size_t i = get_global_id(0);"
+            "    c[i] = a[i] + b[i];"
+            "}";
+
+        const size_t n = 1 << 16;
+
+        Context context;
+        Program program = context.readProgramSource(src.c_str());
+        vector<cl_float> ha(n, 1.0f), hb(n, 2.0f), hc(n);
+        Buffer<cl_float> da = context.createBuffer<cl_float>(n);
+        Buffer<cl_float> db = context.createBuffer<cl_float>(n);
+        Buffer<cl_float> dc = context.createBuffer<cl_float>(n);
+
+        // Each node has its own kernel object, since the arguments differ.
+        Kernel scale_a = program.createKernel("scale");
+        Kernel scale_b = program.createKernel("scale");
+        Kernel add = program.kernel("add");
+        scale_a.setArgs(da, 3.0f);
+        scale_b.setArgs(db, 0.5f);
+        add.setArgs(da, db, dc);
+
+        // a and b are independent until they are added.
+        TaskGraph graph(context, 2);
+        TaskGraph::Node wa = graph.addWrite("write a", &ha[0], da);
+        TaskGraph::Node wb = graph.addWrite("write b", &hb[0], db);
+        TaskGraph::Node sa = graph.addKernel("scale a", scale_a, NDRange(n), {wa});
+        TaskGraph::Node sb = graph.addKernel("scale b", scale_b, NDRange(n), {wb});
+        TaskGraph::Node c = graph.addKernel("add", add, NDRange(n), {sa, sb});
+        TaskGraph::Node rc = graph.addRead("read c", dc, &hc[0], {c});
+        int checked = 0;
+        graph.addHost("check", [&]{
+            for(size_t i = 0; i < n; ++i)
+                if(hc[i] == 4.0f)
+                    ++checked;
+        }, {rc});
+
+        if(graph.queue(sa) == graph.queue(sb)){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        // Replay the graph a few times.
+        for(int run = 0; run < 3; ++run){
+            checked = 0;
+            graph.run().wait();
+            if(checked != int(n)){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+
+        // Runs may be started before the previous one is complete. The
+        // second copy runs on the other queue, and the upload of the next
+        // run must not overwrite da while that copy still reads it.
+        TaskGraph inplace(context, 2);
+        TaskGraph::Node w = inplace.addWrite("write a", &ha[0], da);
+        TaskGraph::Node s = inplace.addKernel("scale a", scale_a, NDRange(n), {w});
+        inplace.addCopy("copy a to c", da, dc, {s});
+        TaskGraph::Node cb = inplace.addCopy("copy a to b", da, db, {s});
+        if(inplace.queue(cb) == inplace.queue(s)){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+        Event last;
+        for(int run = 0; run < 8; ++run)
+            last = inplace.run();
+        last.wait();
+        context.queue().copy(dc, &hc[0]);
+        context.queue().copy(db, &hb[0]);
+        for(size_t i = 0; i < n; ++i){
+            if(hc[i] != 3.0f || hb[i] != 3.0f){
+                cout << "FAILED" << endl;
+                return 1;
+            }
+        }
+
+        TaskGraph::CriticalPath path = graph.criticalPath();
+        cout << "Critical path (" << path.time << "ns):";
+        for(size_t i = 0; i < path.nodes.size(); ++i)
+            cout << " " << graph.name(path.nodes[i]) << " (" << graph.time(path.nodes[i]) << "ns)";
+        cout << endl;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
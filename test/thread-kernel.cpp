@@ -0,0 +1,82 @@
+//          Copyright Shan-Yung Yang 2010.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <clpp/clpp.hpp>
+
+using namespace std;
+using namespace clpp;
+
+const size_t N = 256;
+const int THREADS = 4;
+const int LAUNCHES = 100;
+
+// Each worker fills its own buffer with its number, using its own instance
+// of the kernel, without any lock.
+void Worker(CommandQueue& q, ThreadLocalKernel& fill, Buffer<cl_int> buffer, cl_int value, atomic<bool>& failed)
+{
+    try{
+        Kernel& k = fill.get();
+        for(int i = 0; i < LAUNCHES; ++i){
+            k.setArgs(buffer, value);
+            q.exec(k, N);
+        }
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        failed = true;
+    }
+}
+
+// This example launches the same kernel from several threads.
+int main()
+{
+    try{
+        string src =
+            "kernel void fill(global int* a, int value){"
+            "    a[get_global_id(0)] = value;"
+            "}";
+
+        Context context;
+        CommandQueue& q = context.queue();
+        ThreadLocalKernel fill(context.readProgramSource(src.c_str()).kernel("fill"));
+
+        vector< Buffer<cl_int> > buffers;
+        for(int t = 0; t < THREADS; ++t)
+            buffers.push_back(context.createBuffer<cl_int>(N));
+
+        q.disableEvents();
+        atomic<bool> failed(false);
+        vector<thread> workers;
+        for(int t = 0; t < THREADS; ++t)
+            workers.push_back(thread(Worker, ref(q), ref(fill), buffers[t], cl_int(t), ref(failed)));
+        for(int t = 0; t < THREADS; ++t)
+            workers[t].join();
+        q.enableEvents();
+        if(failed){
+            cout << "FAILED" << endl;
+            return 1;
+        }
+
+        vector<cl_int> result(N);
+        for(int t = 0; t < THREADS; ++t){
+            q.copy(buffers[t], &result[0]);
+            for(size_t i = 0; i < N; ++i){
+                if(result[i] != t){
+                    cout << "FAILED" << endl;
+                    return 1;
+                }
+            }
+        }
+        cout << "Kernel instances: " << fill.size() << endl;
+
+    }catch(const Error& err){
+        cerr << "Error code " << err.code() << ": " << err.what() << " in " << err.function() << endl;
+        return 1;
+    }
+    return 0;
+}
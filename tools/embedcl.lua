@@ -0,0 +1,132 @@
+--          Copyright Shan-Yung Yang 2010.
+-- Distributed under the Boost Software License, Version 1.0.
+--    (See accompanying file LICENSE_1_0.txt or copy at
+--          http://www.boost.org/LICENSE_1_0.txt)
+
+-- embedcl.lua
+--
+-- This program is written to generate a header which embeds OpenCL program
+-- sources into an executable, so that they don't have to be read from files
+-- at run time. It requires Lua 5.3 for 64-bit integer arithmetic.
+--
+-- Usage: lua embedcl.lua [-n name] file.cl ... > header.hpp
+--
+-- The sources are registered by their file names, without directories, and
+-- can be fetched by clpp::EmbeddedSources::get. The name given by -n is used
+-- for the namespace and the include guard of the header, and must be a valid
+-- C identifier. By default, it is "kernels".
+
+-- The 64-bit FNV-1a hash, the same as clpp::Fnv1a64.
+function Fnv1a64(data)
+    local h = 0xcbf29ce484222325
+    for i = 1, #data do
+        h = (h ~ data:byte(i)) * 0x100000001b3
+    end
+    return h
+end
+
+-- Escape a character for a C string literal. The question mark is escaped
+-- to avoid trigraphs.
+ESCAPES = {["\\"]="\\\\", ["\""]="\\\"", ["?"]="\\?", ["\t"]="\\t", ["\r"]="\\r", ["\n"]="\\n"}
+
+function EscapeChar(c)
+    if ESCAPES[c] then
+        return ESCAPES[c]
+    end
+
+    local b = c:byte()
+    if b < 32 or b >= 127 then
+        -- always use three digits, so the next character is never taken
+        -- as part of the escape sequence
+        return string.format("\\%03o", b)
+    end
+    return c
+end
+
+-- Generate a string literal with one line of the source per line of C++.
+function GenLiteral(data)
+    if #data == 0 then
+        return "    \"\""
+    end
+
+    local lines = {}
+    for line in data:gmatch("[^\n]*\n?") do
+        if #line > 0 then
+            lines[#lines+1] = "    \"" .. line:gsub(".", EscapeChar) .. "\""
+        end
+    end
+    return table.concat(lines, "\n")
+end
+
+function BaseName(path)
+    return path:match("([^/\\]*)$")
+end
+
+function ReadFile(path)
+    local f = assert(io.open(path, "rb"))
+    local data = f:read("a")
+    f:close()
+    return data
+end
+
+-- Parse the command line
+local name = "kernels"
+local files = {}
+local i = 1
+while i <= #arg do
+    if arg[i] == "-n" then
+        name = arg[i+1]
+        i = i + 2
+    else
+        files[#files+1] = arg[i]
+        i = i + 1
+    end
+end
+
+if not name or not name:match("^[%a_][%w_]*$") or #files == 0 then
+    io.stderr:write("usage: lua embedcl.lua [-n name] file.cl ... > header.hpp\n")
+    os.exit(1)
+end
+
+-- Generate headers
+local guard = "CLPP_EMBEDDED_" .. string.upper(name) .. "_HPP"
+
+print("#ifndef " .. guard)
+print("#define " .. guard .. "\n")
+
+print("/* This file is generated by embedcl.lua automatically.")
+print(" * DO NOT MODIFY THIS FILE DIRECTLY.")
+print(" * Please edit the sources below and re-generate this file for modification.")
+print(" *")
+for _, path in ipairs(files) do
+    print(" *   " .. path)
+end
+print(" */\n")
+
+print("#include <clpp/embedded.hpp>\n")
+
+print("namespace clpp {")
+print("namespace embedded {")
+print("namespace " .. name .. " {\n")
+
+for k, path in ipairs(files) do
+    local data = ReadFile(path)
+    print(string.format("// %s", BaseName(path)))
+    print(string.format("constexpr char source%d[] =\n%s;\n", k-1, GenLiteral(data)))
+end
+
+print("constexpr EmbeddedSource sources[] = {")
+for k, path in ipairs(files) do
+    local data = ReadFile(path)
+    print(string.format("    { \"%s\", source%d, %d, 0x%016xULL },",
+        BaseName(path):gsub(".", EscapeChar), k-1, #data, Fnv1a64(data)))
+end
+print("};\n")
+
+print(string.format("static const EmbeddedSourceRegistrar registrar(sources, %d);\n", #files))
+
+print("} // namespace " .. name)
+print("} // namespace embedded")
+print("} // namespace clpp\n")
+
+print("#endif // " .. guard)